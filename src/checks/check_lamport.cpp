@@ -0,0 +1,98 @@
+/**
+ * @file check_lamport.cpp
+ * @brief Checks that newerLamportMask() and isNewerLamport() agree with
+ * Lamport::isNewerThan(), at every width and around the wrap of the clocks.
+ * @details This source is built once with the default instruction set and
+ * once without AVX2, so that both the AVX2 and the SSE2 paths of
+ * newerLamportMask() are covered ; its scalar tail is covered by the
+ * batches whose size is not a multiple of the vector width.
+ */
+
+#include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>
+#include <random>   // std::mt19937
+#include <vector>
+
+#include "include.h"
+
+/****************************************/
+/****************************************/
+
+/**
+ * Compares the Lamport functions on clocks of some width.
+ * @param[in] rng The random numbers used to fill the upper bits of the
+ * clocks, which the functions must ignore.
+ * @return The number of mismatches.
+ */
+template <class UIntType>
+static argos::UInt32 checkWidth(std::mt19937& rng) {
+    const argos::UInt32 WIDTH_MASK = static_cast<UIntType>(-1);
+    // Clocks to compare to : around 0, around the wrap, and in between.
+    std::vector<argos::UInt32> others;
+    for (argos::UInt32 d = 0; d <= 2 * LAMPORT_THRESHOLD; ++d) {
+        others.push_back(d);
+        others.push_back(WIDTH_MASK - d);
+        others.push_back(WIDTH_MASK / 2 - LAMPORT_THRESHOLD + d);
+    }
+
+    argos::UInt32 numMismatches = 0;
+    std::vector<swlexp::Lamport32> lamports;
+    std::vector<swlexp::Lamport32> lamportOthers;
+    std::vector<bool> expected;
+    for (argos::UInt32 other : others) {
+        // Every clock from 2 thresholds behind to 2 thresholds ahead.
+        for (argos::SInt32 d = -2 * LAMPORT_THRESHOLD; d <= 2 * LAMPORT_THRESHOLD; ++d) {
+            const UIntType LAMPORT = static_cast<UIntType>(other + d);
+            swlexp::Lamport<UIntType> narrow(LAMPORT);
+            const bool IS_NEWER = narrow.isNewerThan(static_cast<UIntType>(other));
+
+            // The upper bits are garbage, as in the swarmlists, whose own
+            // clocks count past the width of the wire format.
+            const argos::UInt32 UPPER = (argos::UInt32)rng() & ~WIDTH_MASK;
+            const swlexp::Lamport32 WIDE       = UPPER | LAMPORT;
+            const swlexp::Lamport32 WIDE_OTHER = ((argos::UInt32)rng() & ~WIDTH_MASK) | other;
+            if (swlexp::isNewerLamport(WIDE, WIDE_OTHER, WIDTH_MASK) != IS_NEWER) {
+                std::cerr << "isNewerLamport(" << (argos::UInt32)LAMPORT << ", " << other
+                          << ") differs at width " << 8 * sizeof(UIntType) << "\n";
+                ++numMismatches;
+            }
+            lamports.push_back(WIDE);
+            lamportOthers.push_back(WIDE_OTHER);
+            expected.push_back(IS_NEWER);
+        }
+    }
+
+    // Compare in batches of every size, so that the vector loops and the
+    // scalar tail all see each pair.
+    for (argos::UInt32 batchSize = 1; batchSize <= LAMPORT_BATCH_SIZE; ++batchSize) {
+        for (argos::UInt32 i = 0; i + batchSize <= lamports.size(); i += batchSize) {
+            const argos::UInt64 MASK = swlexp::newerLamportMask(
+                &lamports[i], &lamportOthers[i], batchSize, WIDTH_MASK);
+            for (argos::UInt32 j = 0; j < batchSize; ++j) {
+                if (((MASK >> j) & 1) != expected[i + j]) {
+                    std::cerr << "newerLamportMask(" << (argos::UInt32)lamports[i + j] << ", "
+                              << (argos::UInt32)lamportOthers[i + j] << ") differs at width "
+                              << 8 * sizeof(UIntType) << " in a batch of " << batchSize << "\n";
+                    ++numMismatches;
+                }
+            }
+        }
+    }
+    return numMismatches;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+    std::mt19937 rng(42);
+    const argos::UInt32 NUM_MISMATCHES =
+        checkWidth<argos::UInt8 >(rng) +
+        checkWidth<argos::UInt16>(rng) +
+        checkWidth<argos::UInt32>(rng);
+    if (NUM_MISMATCHES > 0) {
+        std::cerr << NUM_MISMATCHES << " mismatches.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
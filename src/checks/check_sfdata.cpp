@@ -0,0 +1,84 @@
+/**
+ * @file check_sfdata.cpp
+ * @brief Checks that the Fenwick tree of SFData picks the same pivots as
+ * the walk over the list of entries that it replaced.
+ * @details A scale-free placement is simulated with a fixed seed: at each
+ * robot, a number of connections is drawn, both structures pick a pivot
+ * for it, and the pivot gains a connection. Every few robots, every number
+ * of connections is tried.
+ */
+
+#include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>
+#include <random>   // std::mt19937, std::uniform_int_distribution
+#include <vector>
+
+#include "loops/ScaleFreeData.h"
+
+/****************************************/
+/****************************************/
+
+/**
+ * The pivots as they used to be picked: the entry at which the cumulated
+ * connections exceed x, walking the entries in order ; the last entry if
+ * none does.
+ */
+static argos::UInt32 walkList(const std::vector<argos::UInt32>& conns, argos::UInt32 x) {
+    argos::UInt32 sum = 0;
+    for (argos::UInt32 i = 0; i < conns.size(); ++i) {
+        sum += conns[i];
+        if (sum > x) {
+            return i;
+        }
+    }
+    return conns.size() - 1;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+    const argos::UInt32 NUM_ROBOTS     = 5000;
+    const argos::UInt32 EXHAUSTIVE_GAP = 97;
+
+    std::mt19937 rng(42);
+    swlexp::SFData data(nullptr);
+    std::vector<argos::UInt32> conns;
+    data.Insert(argos::CVector2());
+    conns.push_back(1);
+
+    argos::UInt32 numMismatches = 0;
+    for (argos::UInt32 robot = 1; robot < NUM_ROBOTS; ++robot) {
+        // SFData::Pick() draws in [0,TotConns] ; the bounds are included,
+        // since the total is one more than the connections of the entries.
+        const argos::UInt32 TOT_CONNS = data.GetTotConns();
+        const argos::UInt32 X = std::uniform_int_distribution<argos::UInt32>(0, TOT_CONNS)(rng);
+        const argos::UInt32 PIVOT = data.Find(X);
+        if (PIVOT != walkList(conns, X)) {
+            std::cerr << "Robot " << robot << ": picked " << PIVOT << " instead of " <<
+                         walkList(conns, X) << " for " << X << " connections\n";
+            ++numMismatches;
+        }
+        if (robot % EXHAUSTIVE_GAP == 0) {
+            for (argos::UInt32 x = 0; x <= TOT_CONNS; ++x) {
+                if (data.Find(x) != walkList(conns, x)) {
+                    std::cerr << "Robot " << robot << ": picked " << data.Find(x) <<
+                                 " instead of " << walkList(conns, x) << " for " << x <<
+                                 " connections\n";
+                    ++numMismatches;
+                }
+            }
+        }
+
+        data.AddConn(PIVOT);
+        ++conns[PIVOT];
+        data.Insert(argos::CVector2(robot, 0));
+        conns.push_back(1);
+    }
+
+    if (numMismatches > 0) {
+        std::cerr << numMismatches << " mismatches.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
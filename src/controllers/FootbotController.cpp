@@ -52,14 +52,22 @@ void swlexp::FootbotController::Init(argos::TConfigurationNode& t_node) {
     argos::TConfigurationNode& rab                = argos::GetNode(sensors,            "range_and_bearing");
     argos::GetNodeAttribute(rab, "packet_drop_prob", c_packetDropProb);
 
+    // The robots are named fb0..fb(N-1) ; their IDs are dense.
+    argos::TConfigurationNode& loop_functions     = argos::GetNode(argos::CSimulator::GetInstance().GetConfigurationRoot(), "loop_functions");
+    RobotId numRobots;
+    argos::GetNodeAttributeOrDefault(loop_functions, "num_robots", numRobots, (RobotId)0);
+
     // Get actuators and sensors and build the messenger
     m_leds    = GetActuator<argos::CCI_LEDsActuator>("leds");
     argos::CCI_RangeAndBearingActuator* rabAct  = GetActuator<argos::CCI_RangeAndBearingActuator>("range_and_bearing");
     argos::CCI_RangeAndBearingSensor*   rabSens = GetSensor  <argos::CCI_RangeAndBearingSensor  >("range_and_bearing");
     m_msn.init(rabAct, rabSens);
+    if (TrafficTrace::getInst().isEnabled()) {
+        m_msn.setCapture(TrafficTrace::getInst().addRobot(m_id));
+    }
 
     // Init the swarmlist.
-    m_swarmlist.init(m_id);
+    m_swarmlist.init(m_id, numRobots);
     m_localSwarmMask = 0x01;
     m_swarmlist.setSwarmMask(m_localSwarmMask);
 }
@@ -68,11 +76,14 @@ void swlexp::FootbotController::Init(argos::TConfigurationNode& t_node) {
 /****************************************/
 
 void swlexp::FootbotController::ControlStep() {
-    static argos::CSpace& space =
+    // Not cached in a static: the control steps may run on several threads.
+    argos::CSpace& space =
         argos::CSimulator::GetInstance().GetSpace();
 
     m_msn.controlStep();
     m_swarmlist.controlStep();
+    // Send what was queued during this step, in a single packet.
+    m_msn.flushTx();
 
     switch(m_swarmlist.getNumActive() % 8) {
         case 0: {
@@ -137,7 +148,7 @@ std::string swlexp::FootbotController::getCsvStatusLog(bool sideEffect) {
     argos::UInt64 NUM_MSGS_TX = m_swarmlist.getNumMsgsTx();
     argos::UInt64 NUM_MSGS_RX = m_swarmlist.getNumMsgsRx();
     argos::UInt64 NUM_MSGS_TX_SINCE_LOG = NUM_MSGS_TX - m_numMsgsTxAtLastLog;
-    argos::UInt64 NUM_MSGS_RX_SINCE_LOG = NUM_MSGS_RX - m_numMsgsTxAtLastLog;
+    argos::UInt64 NUM_MSGS_RX_SINCE_LOG = NUM_MSGS_RX - m_numMsgsRxAtLastLog;
     argos::Real bwTx;
     argos::Real bwRx;
 
@@ -172,14 +183,74 @@ std::string swlexp::FootbotController::getCsvStatusLog(bool sideEffect) {
 /****************************************/
 
 argos::UInt64 swlexp::FootbotController::getTotalNumMessagesTx() {
-    return std::accumulate(c_controllers.begin(), c_controllers.end(), 0, _msgTxElemSum);
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _msgTxElemSum);
 }
 
 /****************************************/
 /****************************************/
 
 argos::UInt64 swlexp::FootbotController::getTotalNumMessagesRx() {
-    return std::accumulate(c_controllers.begin(), c_controllers.end(), 0, _msgRxElemSum);
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _msgRxElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalSwarmlistMemory() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _memoryElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumMessengerAllocations() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _msnAllocElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumBytesTx(Messenger::MsgType type) {
+    argos::UInt64 sum = 0;
+    for (const FootbotController* controller : c_controllers) {
+        sum += controller->m_msn.getNumBytesTx(type);
+    }
+    return sum;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumPaddingBytesTx() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _paddingTxElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumMultiplexedTx() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _multiplexedTxElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumEntriesRx() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _entriesRxElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumUsefulEntriesRx() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _usefulEntriesRxElemSum);
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt64 swlexp::FootbotController::getTotalNumDuplicateEntriesRx() {
+    return std::accumulate(c_controllers.begin(), c_controllers.end(), (argos::UInt64)0, _duplicateEntriesRxElemSum);
 }
 
 /****************************************/
@@ -202,9 +273,20 @@ void swlexp::FootbotController::forceConsensus() {
             return std::stoi(idStr.substr(std::string("fb").size()));
         });
 
-    // Force each swarmlist's consensus.
+    if (c_controllers.empty()) {
+        return;
+    }
+
+    if (TrafficTrace::getInst().isEnabled()) {
+        TrafficTrace::getInst().recordConsensus(existingRobots);
+    }
+    // Build the consensus state once, then clone it in each swarmlist.
+    Swarmlist::prepareConsensus(
+        existingRobots,
+        (*c_controllers.begin())->m_swarmlist.getDenseIdBound());
     for (FootbotController* ctrl : c_controllers) {
-        ctrl->m_swarmlist.forceConsensus(existingRobots);
+        ctrl->m_swarmlist.forceConsensus();
+        ctrl->m_msn.resetCounters();
     }
 }
 
@@ -75,6 +75,61 @@ namespace swlexp {
         static
         argos::UInt64 getTotalNumMessagesRx();
 
+        /**
+         * Gets the number of bytes of memory held by the swarmlists of
+         * all the footbots.
+         */
+        static
+        argos::UInt64 getTotalSwarmlistMemory();
+
+        /**
+         * Gets the number of times the buffers of the messengers of all
+         * the footbots grew. In steady state, this does not grow.
+         */
+        static
+        argos::UInt64 getTotalNumMessengerAllocations();
+
+        /**
+         * Gets the number of bytes sent in messages of a type by all the
+         * footbots.
+         * @see Messenger::getNumBytesTx()
+         */
+        static
+        argos::UInt64 getTotalNumBytesTx(Messenger::MsgType type);
+
+        /**
+         * Gets the number of padding bytes sent by all the footbots.
+         */
+        static
+        argos::UInt64 getTotalNumPaddingBytesTx();
+
+        /**
+         * Gets the number of packets sent by all the footbots that carried
+         * several messages.
+         */
+        static
+        argos::UInt64 getTotalNumMultiplexedTx();
+
+        /**
+         * Gets the number of swarmlist entries received by all the footbots.
+         */
+        static
+        argos::UInt64 getTotalNumEntriesRx();
+
+        /**
+         * Gets the number of received swarmlist entries that were applied,
+         * for all the footbots.
+         */
+        static
+        argos::UInt64 getTotalNumUsefulEntriesRx();
+
+        /**
+         * Gets the number of received swarmlist entries that duplicated
+         * another entry of the same timestep, for all the footbots.
+         */
+        static
+        argos::UInt64 getTotalNumDuplicateEntriesRx();
+
         /**
          * Gets the total number of swarmlist entries in the entire swarm.
          */
@@ -154,6 +209,34 @@ namespace swlexp {
         argos::UInt64 _msgRxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
         { return lhs + rhs->m_swarmlist.getNumMsgsRx(); }
 
+        inline static
+        argos::UInt64 _memoryElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_swarmlist.getMemoryUsage(); }
+
+        inline static
+        argos::UInt64 _msnAllocElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_msn.getNumAllocations(); }
+
+        inline static
+        argos::UInt64 _paddingTxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_msn.getNumPaddingBytesTx(); }
+
+        inline static
+        argos::UInt64 _multiplexedTxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_msn.getNumMultiplexedTx(); }
+
+        inline static
+        argos::UInt64 _entriesRxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_swarmlist.getNumEntriesRx(); }
+
+        inline static
+        argos::UInt64 _usefulEntriesRxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_swarmlist.getNumUsefulEntriesRx(); }
+
+        inline static
+        argos::UInt64 _duplicateEntriesRxElemSum(argos::UInt64 lhs, const swlexp::FootbotController* rhs)
+        { return lhs + rhs->m_swarmlist.getNumDuplicateEntriesRx(); }
+
     // ==============================
     // =         ATTRIBUTES         =
     // ==============================
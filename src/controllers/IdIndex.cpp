@@ -0,0 +1,100 @@
+#include <algorithm> // std::fill
+
+#include "IdIndex.h"
+
+namespace swlexp {
+    const argos::UInt32 IdIndex::NOT_FOUND;
+}
+
+static const argos::UInt8 INITIAL_SHIFT = 32 - 4; ///< Start with 16 slots.
+
+/****************************************/
+/****************************************/
+
+swlexp::IdIndex::IdIndex() {
+    clear();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::IdIndex::clear() {
+    const Slot EMPTY = { 0, NOT_FOUND };
+    m_shift = INITIAL_SHIFT;
+    m_mask  = (1u << (32 - m_shift)) - 1;
+    m_size  = 0;
+    m_slots.assign(m_mask + 1, EMPTY);
+    m_slots.shrink_to_fit();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::IdIndex::clearKeepingCapacity() {
+    const Slot EMPTY = { 0, NOT_FOUND };
+    std::fill(m_slots.begin(), m_slots.end(), EMPTY);
+    m_size = 0;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt32 swlexp::IdIndex::find(RobotId robot) const {
+    for (argos::UInt32 i = _home(robot); ; i = (i + 1) & m_mask) {
+        const Slot& slot = m_slots[i];
+        if (slot.index == NOT_FOUND) {
+            return NOT_FOUND;
+        }
+        if (slot.robot == robot) {
+            return slot.index;
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt32 swlexp::IdIndex::findOrInsert(RobotId robot,
+                                            argos::UInt32 newIndex,
+                                            bool& inserted) {
+    for (argos::UInt32 i = _home(robot); ; i = (i + 1) & m_mask) {
+        Slot& slot = m_slots[i];
+        if (slot.index == NOT_FOUND) {
+            // Not found ; take the empty slot.
+            slot.robot = robot;
+            slot.index = newIndex;
+            inserted = true;
+            // Keep the load factor at or below 1/2 so that probe
+            // sequences stay short.
+            if (++m_size > (m_mask + 1) / 2) {
+                _grow();
+            }
+            return newIndex;
+        }
+        if (slot.robot == robot) {
+            inserted = false;
+            return slot.index;
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::IdIndex::_grow() {
+    const Slot EMPTY = { 0, NOT_FOUND };
+    std::vector<Slot> oldSlots(2 * (m_mask + 1), EMPTY);
+    oldSlots.swap(m_slots);
+    --m_shift;
+    m_mask = 2 * m_mask + 1;
+
+    for (const Slot& slot : oldSlots) {
+        if (slot.index != NOT_FOUND) {
+            argos::UInt32 i = _home(slot.robot);
+            while (m_slots[i].index != NOT_FOUND) {
+                i = (i + 1) & m_mask;
+            }
+            m_slots[i] = slot;
+        }
+    }
+}
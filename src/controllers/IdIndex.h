@@ -0,0 +1,119 @@
+/**
+ * @file IdIndex.h
+ * @brief Definition of the IdIndex class.
+ */
+
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <vector>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * Flat, open-addressing map from a robot ID to an index.
+     * Slots are stored contiguously and probed linearly, so that a lookup
+     * usually touches a single cache line and never allocates nor throws.
+     */
+    class IdIndex {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        IdIndex();
+
+        /**
+         * Removes all the IDs from the index, and releases its memory.
+         */
+        void clear();
+
+        /**
+         * Removes all the IDs from the index, but keeps its memory so that
+         * it can be refilled without allocating.
+         */
+        void clearKeepingCapacity();
+
+        /**
+         * Finds the index associated with a robot ID.
+         * @param[in] robot The robot ID to look for.
+         * @return The index associated with the robot ID, or NOT_FOUND
+         * if the ID is not in the index.
+         */
+        argos::UInt32 find(RobotId robot) const;
+
+        /**
+         * Finds the index associated with a robot ID, and inserts it
+         * with the specified index if it is not found, using a single
+         * probe sequence.
+         * @param[in] robot The robot ID to look for.
+         * @param[in] newIndex The index to associate with the robot ID
+         * if it is not found.
+         * @param[out] inserted Whether the robot ID was inserted.
+         * @return The index associated with the robot ID.
+         */
+        argos::UInt32 findOrInsert(RobotId robot, argos::UInt32 newIndex, bool& inserted);
+
+        /**
+         * Determines the number of IDs in the index.
+         */
+        inline
+        argos::UInt32 getSize() const { return m_size; }
+
+        /**
+         * Determines the number of bytes of memory held by the index,
+         * besides the index object itself.
+         */
+        inline
+        size_t getMemoryUsage() const
+        { return m_slots.capacity() * sizeof(Slot); }
+
+    private:
+
+        /**
+         * Doubles the number of slots and reinserts every ID.
+         */
+        void _grow();
+
+        /**
+         * Determines the slot at which to start probing for a robot ID.
+         */
+        inline
+        argos::UInt32 _home(RobotId robot) const { return (robot * 2654435769u) >> m_shift; }
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    public:
+
+        static const argos::UInt32 NOT_FOUND = (argos::UInt32)-1; ///< Value returned when an ID is not in the index.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        /**
+         * A slot of the index. The slot is empty if its index is NOT_FOUND.
+         */
+        struct Slot {
+            RobotId       robot;
+            argos::UInt32 index;
+        };
+
+        std::vector<Slot> m_slots; ///< Slots ; their number is always a power of two.
+        argos::UInt32 m_mask;      ///< Number of slots - 1.
+        argos::UInt8  m_shift;     ///< 32 - log2(number of slots).
+        argos::UInt32 m_size;      ///< Number of IDs in the index.
+
+    };
+
+}
+
+#endif // !ID_INDEX_H
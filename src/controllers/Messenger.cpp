@@ -1,3 +1,8 @@
+#include <algorithm> // std::stable_sort
+#include <cstring>   // std::memcpy
+#include <stdexcept> // std::out_of_range, std::length_error
+#include <string>
+
 #include "Messenger.h"
 
 /****************************************/
@@ -7,8 +12,19 @@ swlexp::Messenger::Messenger()
     : m_transmitter(nullptr)
     , m_receiver(nullptr)
     , m_isFree(true)
+    , m_numAllocations(0)
+    , m_numTxQueued(0)
+    , m_txFirstType(MSG_TYPE_NOTHING)
+    , m_txFirstSize(0)
+    , m_capture(nullptr)
 {
-
+    for (argos::UInt32 type = 0; type < MSG_TYPE_COUNT; ++type) {
+        m_txQueuedBytes[type] = 0;
+        m_txPolicies[type].priority = 0;
+        m_txPolicies[type].byteBudget = 0;
+        m_txOrder[type] = type;
+    }
+    resetCounters();
 }
 
 /****************************************/
@@ -22,15 +38,152 @@ swlexp::Messenger::~Messenger() {
 /****************************************/
 
 void swlexp::Messenger::sendMsgTx(const argos::CByteArray& msgTx) {
-    m_transmitter->SetData(msgTx);
-    m_isFree = false;
+    const MsgType TYPE = static_cast<MsgType>(msgTx[0]);
+    argos::UInt8* msg = queueMsgTx(TYPE, msgTx.Size());
+    std::memcpy(msg, msgTx.ToCArray(), msgTx.Size());
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt8* swlexp::Messenger::queueMsgTx(MsgType type, argos::UInt16 size) {
+    if (type >= MSG_TYPE_COUNT) {
+        throw std::out_of_range("Unknown message type " + std::to_string(type) + ".");
+    }
+    if (size == 0 || size > getPacketSize()) {
+        throw std::length_error("Message of " + std::to_string(size) +
+                                " bytes does not fit in a packet.");
+    }
+
+    // Most timesteps send a single message, so the first message is
+    // encoded straight into the packet. Once another one is queued, it
+    // is moved to its queue, to be packed with the others.
+    argos::UInt8* msg;
+    if (m_numTxQueued == 0) {
+        _clearTxBuffer();
+        msg = m_txBuffer.ToCArray();
+        m_txFirstType = type;
+        m_txFirstSize = size;
+    }
+    else {
+        if (m_numTxQueued == 1) {
+            std::memcpy(_stageMsgTx(m_txFirstType, m_txFirstSize),
+                        m_txBuffer.ToCArray(), m_txFirstSize);
+        }
+        msg = _stageMsgTx(type, size);
+    }
+    msg[0] = type;
+
+    // In a multiplexed packet, the message is preceded by its size on one byte.
+    m_txQueuedBytes[type] += 1 + size;
+    ++m_numTxQueued;
+    return msg;
 }
 
 /****************************************/
 /****************************************/
 
-void swlexp::Messenger::sendMsgTx(argos::CByteArray&& msgTx) {
-    m_transmitter->SetData(msgTx);
+argos::UInt16 swlexp::Messenger::getTxSpace(MsgType type) const {
+    if (m_numTxQueued == 0) {
+        return getPacketSize();
+    }
+
+    // The message goes in a multiplexed packet, after the multiplex type,
+    // the queued messages and its own size.
+    argos::SInt32 space = (argos::SInt32)getPacketSize() - 2;
+    for (argos::UInt32 t = 0; t < MSG_TYPE_COUNT; ++t) {
+        space -= m_txQueuedBytes[t];
+    }
+    const argos::UInt16 BUDGET = m_txPolicies[type].byteBudget;
+    if (BUDGET > 0) {
+        space = std::min(space, (argos::SInt32)BUDGET - m_txQueuedBytes[type] - 1);
+    }
+    // The size of a multiplexed message fits on one byte.
+    space = std::min(space, (argos::SInt32)UINT8_MAX);
+    return space > 0 ? space : 0;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Messenger::setTxPolicy(MsgType type, argos::UInt8 priority, argos::UInt16 byteBudget) {
+    if (type >= MSG_TYPE_COUNT) {
+        throw std::out_of_range("Unknown message type " + std::to_string(type) + ".");
+    }
+    m_txPolicies[type].priority = priority;
+    m_txPolicies[type].byteBudget = byteBudget;
+
+    // Sort the types once here, rather than at every flush.
+    for (argos::UInt32 t = 0; t < MSG_TYPE_COUNT; ++t) {
+        m_txOrder[t] = t;
+    }
+    std::stable_sort(m_txOrder, m_txOrder + MSG_TYPE_COUNT,
+                     [this](argos::UInt8 a, argos::UInt8 b) {
+                         return m_txPolicies[a].priority < m_txPolicies[b].priority;
+                     });
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Messenger::flushTx() {
+    if (m_numTxQueued == 0) {
+        return;
+    }
+
+    const argos::UInt16 PACKET_SIZE = getPacketSize();
+    if (m_numTxQueued == 1) {
+        // A single message was encoded in the packet, padded with zeros.
+        m_numBytesTx[m_txFirstType] += m_txFirstSize;
+        m_numPaddingBytesTx += PACKET_SIZE - m_txFirstSize;
+    }
+    else {
+        // Pack the messages by priority, each preceded by its size.
+        _clearTxBuffer();
+        argos::UInt8* packet = m_txBuffer.ToCArray();
+        packet[0] = MSG_TYPE_MULTI;
+        argos::UInt16 pos = 1;
+        argos::UInt32 numPacked = 0;
+        for (argos::UInt8 type : m_txOrder) {
+            const std::vector<argos::UInt8>& queue = m_txQueues[type];
+            const argos::UInt16 BUDGET = m_txPolicies[type].byteBudget;
+            argos::UInt16 used = 0;
+            for (size_t i = 0; i < queue.size(); ) {
+                argos::UInt16 size;
+                std::memcpy(&size, &queue[i], sizeof(argos::UInt16));
+                i += sizeof(argos::UInt16);
+                if (size <= UINT8_MAX &&
+                    pos + 1 + size <= PACKET_SIZE &&
+                    (BUDGET == 0 || used + 1 + size <= BUDGET)) {
+                    packet[pos] = size;
+                    std::memcpy(&packet[pos + 1], &queue[i], size);
+                    pos += 1 + size;
+                    used += 1 + size;
+                    m_numBytesTx[type] += size;
+                    m_numBytesTx[MSG_TYPE_MULTI] += 1;
+                    ++numPacked;
+                }
+                else {
+                    ++m_numTxDropped;
+                }
+                i += size;
+            }
+        }
+        m_numBytesTx[MSG_TYPE_MULTI] += 1;
+        m_numPaddingBytesTx += PACKET_SIZE - pos;
+        if (numPacked > 1) {
+            ++m_numMultiplexedTx;
+        }
+    }
+
+    for (argos::UInt32 type = 0; type < MSG_TYPE_COUNT; ++type) {
+        m_txQueues[type].clear();
+        m_txQueuedBytes[type] = 0;
+    }
+    m_numTxQueued = 0;
+
+    // The actuator copies the data into its own packet-sized buffer.
+    m_transmitter->SetData(m_txBuffer);
     m_isFree = false;
 }
 
@@ -44,19 +197,33 @@ const argos::CCI_RangeAndBearingSensor::TReadings& swlexp::Messenger::getMsgsRx(
 /****************************************/
 /****************************************/
 
+void swlexp::Messenger::resetCounters() {
+    m_numTxDropped      = 0;
+    m_numPaddingBytesTx = 0;
+    m_numMultiplexedTx  = 0;
+    for (argos::UInt32 type = 0; type < MSG_TYPE_COUNT; ++type) {
+        m_numBytesTx[type] = 0;
+        m_numMsgsRx[type]  = 0;
+    }
+}
+
+/****************************************/
+/****************************************/
+
 void swlexp::Messenger::registerCallback(MsgType type, Callback& callback) {
-    m_callbacks.insert(std::make_pair(type, &callback));
+    _addHandler(type, &callback, &Messenger::_invokeVirtual);
 }
 
 /****************************************/
 /****************************************/
 
-void swlexp::Messenger::removeCallback(MsgType type, Callback& callback) {
-    auto callbacksOfThatType = m_callbacks.equal_range(type);
-    for (auto it = callbacksOfThatType.first; it != callbacksOfThatType.second; ++it) {
-        if (it->second == &callback) {
-            m_callbacks.erase(it);
-            break;
+void swlexp::Messenger::removeCallback(Callback& callback) {
+    for (std::vector<Handler>& handlers : m_handlers) {
+        for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+            if (it->object == &callback) {
+                handlers.erase(it);
+                return;
+            }
         }
     }
 }
@@ -64,10 +231,27 @@ void swlexp::Messenger::removeCallback(MsgType type, Callback& callback) {
 /****************************************/
 /****************************************/
 
-void swlexp::Messenger::removeCallback(Callback& callback) {
-    for (auto it = m_callbacks.begin(); it != m_callbacks.end(); ++it) {
-        if (it->second == &callback) {
-            m_callbacks.erase(it);
+void swlexp::Messenger::_addHandler(MsgType type,
+                                    void* object,
+                                    void (*invoke)(void*, const TPackets&)) {
+    if (type >= MSG_TYPE_COUNT) {
+        throw std::out_of_range("Unknown message type " + std::to_string(type) + ".");
+    }
+    const Handler HANDLER = { object, invoke };
+    m_handlers[type].push_back(HANDLER);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Messenger::_removeHandler(MsgType type, const void* object) {
+    if (type >= MSG_TYPE_COUNT) {
+        return;
+    }
+    std::vector<Handler>& handlers = m_handlers[type];
+    for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+        if (it->object == object) {
+            handlers.erase(it);
             break;
         }
     }
@@ -76,16 +260,120 @@ void swlexp::Messenger::removeCallback(Callback& callback) {
 /****************************************/
 /****************************************/
 
+void swlexp::Messenger::_unpackRx(const argos::CCI_RangeAndBearingSensor::TReadings& readings) {
+
+    // Count the messages first, so that the unpacked packets are not
+    // moved once pointers to them are taken.
+    size_t numUnpacked = 0;
+    for (const argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
+        if (packet.Data[0] == MSG_TYPE_MULTI) {
+            for (size_t pos = 1; pos < packet.Data.Size() && packet.Data[pos] > 0; pos += 1 + packet.Data[pos]) {
+                ++numUnpacked;
+            }
+        }
+    }
+    if (m_rxUnpacked.size() < numUnpacked) {
+        const size_t CAPACITY = m_rxUnpacked.capacity();
+        m_rxUnpacked.resize(numUnpacked);
+        if (m_rxUnpacked.capacity() != CAPACITY) {
+            ++m_numAllocations;
+        }
+    }
+
+    size_t idx = 0;
+    for (const argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
+        if (packet.Data[0] != MSG_TYPE_MULTI) {
+            continue;
+        }
+        const argos::UInt8* data = packet.Data.ToCArray();
+        for (size_t pos = 1; pos < packet.Data.Size() && data[pos] > 0; pos += 1 + data[pos]) {
+            // Drop a truncated last message.
+            const size_t SIZE = std::min<size_t>(data[pos], packet.Data.Size() - pos - 1);
+            argos::CCI_RangeAndBearingSensor::SPacket& unpacked = m_rxUnpacked[idx];
+            unpacked.Range = packet.Range;
+            unpacked.HorizontalBearing = packet.HorizontalBearing;
+            unpacked.VerticalBearing = packet.VerticalBearing;
+            // The data only moves when it grows.
+            const argos::UInt8* OLD_DATA = unpacked.Data.ToCArray();
+            unpacked.Data.Resize(SIZE);
+            if (unpacked.Data.ToCArray() != OLD_DATA) {
+                ++m_numAllocations;
+            }
+            std::memcpy(unpacked.Data.ToCArray(), &data[pos + 1], SIZE);
+            if (SIZE > 0 && data[pos + 1] < MSG_TYPE_COUNT && data[pos + 1] != MSG_TYPE_MULTI) {
+                _addMsgRx(data[pos + 1], &unpacked);
+            }
+            ++idx;
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Messenger::_clearTxBuffer() {
+    const argos::UInt16 PACKET_SIZE = getPacketSize();
+    if (m_txBuffer.Size() != PACKET_SIZE) {
+        const argos::UInt8* OLD_DATA = m_txBuffer.ToCArray();
+        m_txBuffer.Resize(PACKET_SIZE);
+        if (m_txBuffer.ToCArray() != OLD_DATA) {
+            ++m_numAllocations;
+        }
+    }
+    m_txBuffer.Zero();
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt8* swlexp::Messenger::_stageMsgTx(MsgType type, argos::UInt16 size) {
+    // Each message is preceded by its size on two bytes.
+    std::vector<argos::UInt8>& queue = m_txQueues[type];
+    const size_t POS = queue.size();
+    const size_t CAPACITY = queue.capacity();
+    queue.resize(POS + sizeof(argos::UInt16) + size, 0);
+    if (queue.capacity() != CAPACITY) {
+        ++m_numAllocations;
+    }
+    std::memcpy(&queue[POS], &size, sizeof(argos::UInt16));
+    return &queue[POS + sizeof(argos::UInt16)];
+}
+
+/****************************************/
+/****************************************/
+
 void swlexp::Messenger::controlStep() {
 
     const argos::CCI_RangeAndBearingSensor::TReadings& readings =
         m_receiver->GetReadings();
+    if (m_capture != nullptr) {
+        m_capture->record(readings);
+    }
 
+    // Group the packets by type, so that each callback is called once
+    // with all the packets of its type.
+    for (TPackets& packets : m_packetsByType) {
+        packets.clear();
+    }
     for (const argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
-        MsgType type = (MsgType)packet.Data[0];
-        auto callbacksOfThatType = m_callbacks.equal_range(type);
-        for (auto it = callbacksOfThatType.first; it != callbacksOfThatType.second; ++it) {
-            (*it->second)(packet);
+        const argos::UInt8 TYPE = packet.Data[0];
+        if (TYPE < MSG_TYPE_COUNT) {
+            _addMsgRx(TYPE, &packet);
+        }
+    }
+    // The messages of multiplexed packets come after the plain packets
+    // of their type.
+    if (!m_packetsByType[MSG_TYPE_MULTI].empty()) {
+        m_packetsByType[MSG_TYPE_MULTI].clear();
+        _unpackRx(readings);
+    }
+
+    for (argos::UInt32 type = 0; type < MSG_TYPE_COUNT; ++type) {
+        const TPackets& packets = m_packetsByType[type];
+        if (!packets.empty()) {
+            for (const Handler& handler : m_handlers[type]) {
+                handler.invoke(handler.object, packets);
+            }
         }
     }
 
@@ -9,14 +9,23 @@
 #include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_actuator.h>
 #include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
 #include <argos3/core/utility/datatypes/byte_array.h>
-#include <unordered_map>
+#include <vector>
 
 #include "include.h"
+#include "TrafficTrace.h"
 
 namespace swlexp {
 
     /**
-     * Encapsulates sending and receiving messages.
+     * @brief Encapsulates sending and receiving messages.
+     * @details Messages are queued during a timestep and packed in the
+     * single packet sent at the end of it by flushTx(). When only one
+     * message is queued, the packet is that message, padded with zeros ;
+     * it is then encoded straight into the packet.
+     * Otherwise, the packet is a MSG_TYPE_MULTI message: its type, then
+     * each message preceded by its size on one byte, until a size of 0 or
+     * the end of the packet. Multiplexed packets are unpacked before the
+     * callbacks are called, so the callbacks only ever see plain messages.
      */
     class Messenger {
 
@@ -30,6 +39,11 @@ namespace swlexp {
 
     public:
 
+        /**
+         * Type for a set of received packets.
+         */
+        typedef std::vector<const argos::CCI_RangeAndBearingSensor::SPacket*> TPackets;
+
         /**
          * Type for a callback object.
          */
@@ -41,6 +55,18 @@ namespace swlexp {
             virtual
             void operator()(const argos::CCI_RangeAndBearingSensor::SPacket& packet) { }
 
+            /**
+             * Deals with all the packets of a certain type received during
+             * a timestep. By default, this deals with each packet in turn.
+             * @param[in] packets The packets, in the order they were
+             * received.
+             */
+            virtual
+            void operator()(const TPackets& packets) {
+                for (const argos::CCI_RangeAndBearingSensor::SPacket* packet : packets)
+                    (*this)(*packet);
+            }
+
             virtual
             bool operator==(const Callback& other) { return this == &other; }
         };
@@ -50,15 +76,28 @@ namespace swlexp {
          */
         enum MsgType : argos::UInt8 {
             MSG_TYPE_NOTHING = 0,
-            MSG_TYPE_SWARM
+            MSG_TYPE_SWARM,
+            MSG_TYPE_DIGEST,
+            MSG_TYPE_MULTI,  ///< Several messages packed in a packet.
+            MSG_TYPE_COUNT   ///< Number of message types ; packets of other types are ignored.
+        };
+
+    private:
+
+        /**
+         * Callback registered for a message type.
+         */
+        struct Handler {
+            void* object;                                  ///< The callback object.
+            void (*invoke)(void* object, const TPackets&); ///< Calls the callback object.
         };
 
         /**
-         * Hash functor for the type buckets.
+         * How the messages of a type are packed.
          */
-        struct MyHash {
-            inline
-            size_t operator()(MsgType type) const { return (size_t)type; }
+        struct TxPolicy {
+            argos::UInt8  priority;   ///< Messages of lower priorities are packed first.
+            argos::UInt16 byteBudget; ///< Most bytes of a multiplexed packet given to the type, sizes included ; 0 if unlimited.
         };
 
     // ==============================
@@ -86,25 +125,114 @@ namespace swlexp {
         void controlStep();
 
         /**
-         * Sets a message to be sent.
-         * @warning This overrides any previous message that would have
-         * been sent.
-         * @see isFree()
+         * Records the packets received at every timestep.
+         * @param[in] capture Where to record the packets ; nullptr to stop
+         * recording.
+         */
+        inline
+        void setCapture(TrafficTrace::RobotTrace* capture) { m_capture = capture; }
+
+        /**
+         * Queues a copy of a message to be sent.
          * @param[in] msgTx The message to send.
          * @note Inside the byte array, the type is the first byte, i.e.,
          * msgTx.ToCArray()[0]
+         * @see queueMsgTx()
          */
         void sendMsgTx(const argos::CByteArray& msgTx);
 
         /**
-         * Sets a message to be sent.
-         * @warning This overrides any previous message that would have
-         * been sent.
-         * @param[in] msgTx The message to send.
-         * @note Inside the byte array, the type is the first byte, i.e.,
-         * msgTx.ToCArray()[0]
+         * Queues a message to be sent at the end of the timestep, so that
+         * it can be encoded directly into the queue.
+         * @throw std::length_error The message does not fit in a packet.
+         * @param[in] type The type of the message ; it is written as the
+         * first byte. The other bytes are zeroed.
+         * @param[in] size The size of the message, type included.
+         * @return The first byte of the message. It is valid until the
+         * next message is queued.
+         * @see getTxSpace()
+         */
+        argos::UInt8* queueMsgTx(MsgType type, argos::UInt16 size);
+
+        /**
+         * Determines the largest message of a type that fits in the
+         * packet, along with the messages already queued.
+         * @param[in] type The type of the message.
+         * @return The largest size of a message, type included ; 0 if none fits.
+         */
+        argos::UInt16 getTxSpace(MsgType type) const;
+
+        /**
+         * Sets how the messages of a type are packed when several
+         * messages are queued in the same timestep.
+         * By default, all types have a priority of 0 and no budget ;
+         * types of the same priority are packed in the order of their
+         * values.
+         * @param[in] type The type of the messages.
+         * @param[in] priority Messages of lower priorities are packed first.
+         * @param[in] byteBudget Most bytes of a multiplexed packet given to
+         * the type, including a byte per message for its size ; 0 if unlimited.
+         */
+        void setTxPolicy(MsgType type, argos::UInt8 priority, argos::UInt16 byteBudget);
+
+        /**
+         * Packs the queued messages into a packet and sends it, then
+         * empties the queue. The messages that do not fit, or exceed
+         * the budget of their type, are dropped.
+         * This should be called once, at the end of every timestep.
+         */
+        void flushTx();
+
+        /**
+         * Gets the number of queued messages that were dropped because
+         * they did not fit in their packet.
+         */
+        inline
+        argos::UInt64 getNumTxDropped() const { return m_numTxDropped; }
+
+        /**
+         * Gets the number of bytes sent in messages of a type, types
+         * included. For MSG_TYPE_MULTI, this is the overhead of
+         * multiplexing, i.e., the multiplex types and the message sizes.
+         */
+        inline
+        argos::UInt64 getNumBytesTx(MsgType type) const { return m_numBytesTx[type]; }
+
+        /**
+         * Gets the number of bytes of the sent packets that were only
+         * padding.
+         */
+        inline
+        argos::UInt64 getNumPaddingBytesTx() const { return m_numPaddingBytesTx; }
+
+        /**
+         * Gets the number of packets sent that carried several messages.
+         */
+        inline
+        argos::UInt64 getNumMultiplexedTx() const { return m_numMultiplexedTx; }
+
+        /**
+         * Gets the number of messages of a type received, counting the
+         * messages of multiplexed packets.
+         */
+        inline
+        argos::UInt64 getNumMsgsRx(MsgType type) const { return m_numMsgsRx[type]; }
+
+        /**
+         * Gets the number of times the buffers of the messenger grew, i.e.,
+         * the queues and packet of the sent messages, and the unpacked and
+         * grouped received messages. In steady state, this does not grow.
+         * @note Unlike the traffic counters, this is not reset by
+         * resetCounters().
+         */
+        inline
+        argos::UInt64 getNumAllocations() const { return m_numAllocations; }
+
+        /**
+         * Sets the traffic counters back to 0, e.g., when the swarmlists
+         * are forced to consensus and the traffic before does not count.
          */
-        void sendMsgTx(argos::CByteArray&& msgTx);
+        void resetCounters();
 
         /**
          * Fetches the messages received since the last timestep.
@@ -128,12 +256,39 @@ namespace swlexp {
          */
         void registerCallback(MsgType type, Callback& callback);
 
+        /**
+         * @brief Registers a callback object of a known type that will be
+         * called whenever a message of a certain type is received.
+         * @details T::operator()(const TPackets&) is called directly, not
+         * through the vtable, so T must be the actual type of the object,
+         * e.g., a final class. T does not need to derive from Callback.
+         * @param[in] type The type of message to call the callback on.
+         * @param[in] callback The object to call whenever a message of
+         * the desired type is received.
+         */
+        template <class T>
+        inline
+        void registerCallback(MsgType type, T& callback)
+        { _addHandler(type, &callback, &Messenger::_invoke<T>); }
+
         /**
          * Removes a callback function.
          * @param[in] type The message type the callback was called with.
          * @param[in] callback The function to remove.
          */
-        void removeCallback(MsgType type, Callback& callback);
+        inline
+        void removeCallback(MsgType type, Callback& callback)
+        { _removeHandler(type, &callback); }
+
+        /**
+         * Removes a callback object that was registered with its type.
+         * @param[in] type The message type the callback was called with.
+         * @param[in] callback The object to remove.
+         */
+        template <class T>
+        inline
+        void removeCallback(MsgType type, T& callback)
+        { _removeHandler(type, &callback); }
 
         /**
          * Removes a callback function.
@@ -148,16 +303,101 @@ namespace swlexp {
         Messenger(Messenger&) = delete;
         Messenger& operator=(const Messenger&) = delete;
 
+        /**
+         * Adds a callback to the dispatch table.
+         */
+        void _addHandler(MsgType type, void* object, void (*invoke)(void*, const TPackets&));
+
+        /**
+         * Removes the first matching callback from the dispatch table.
+         */
+        void _removeHandler(MsgType type, const void* object);
+
+        /**
+         * Unpacks the multiplexed packets received during the timestep
+         * into m_rxUnpacked.
+         * @param[in] readings The packets received during the timestep.
+         */
+        void _unpackRx(const argos::CCI_RangeAndBearingSensor::TReadings& readings);
+
+        /**
+         * Sizes the packet being sent and zeroes it.
+         */
+        void _clearTxBuffer();
+
+        /**
+         * Appends a message to the queue of its type, to be packed in a
+         * multiplexed packet.
+         * @param[in] type The type of the message.
+         * @param[in] size The size of the message, type included.
+         * @return The first byte of the message, zeroed.
+         */
+        argos::UInt8* _stageMsgTx(MsgType type, argos::UInt16 size);
+
+        /**
+         * Adds a received message to those of its type.
+         */
+        inline
+        void _addMsgRx(argos::UInt8 type, const argos::CCI_RangeAndBearingSensor::SPacket* packet) {
+            TPackets& packets = m_packetsByType[type];
+            if (packets.size() == packets.capacity()) {
+                ++m_numAllocations;
+            }
+            packets.push_back(packet);
+            ++m_numMsgsRx[type];
+        }
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    private:
+
+        /**
+         * Calls a callback object of a known type.
+         */
+        template <class T>
+        static
+        void _invoke(void* object, const TPackets& packets)
+        { (*static_cast<T*>(object)).T::operator()(packets); }
+
+        /**
+         * Calls a callback object through its vtable.
+         */
+        static
+        void _invokeVirtual(void* object, const TPackets& packets)
+        { (*static_cast<Callback*>(object))(packets); }
+
     // ==============================
     // =         ATTRIBUTES         =
     // ==============================
 
     private:
 
-        std::unordered_multimap<MsgType, Callback*, MyHash> m_callbacks; ///< Callback functions
+        std::vector<Handler> m_handlers[MSG_TYPE_COUNT]; ///< Type => Callbacks, in the order they were registered.
         argos::CCI_RangeAndBearingActuator* m_transmitter; ///< Communication actuator.
         argos::CCI_RangeAndBearingSensor*   m_receiver;    ///< Communication sensor.
         argos::UInt8 m_isFree; ///< Whether the messenger is free to send another message.
+        TPackets m_packetsByType[MSG_TYPE_COUNT]; ///< Type => Packets of that type received during the current timestep.
+        argos::CByteArray m_txBuffer;          ///< Packet being sent, kept from one timestep to the next.
+        argos::UInt64 m_numTxDropped;          ///< Number of queued messages that did not fit in their packet.
+        argos::UInt64 m_numBytesTx[MSG_TYPE_COUNT]; ///< Type => Number of bytes sent in messages of that type.
+        argos::UInt64 m_numPaddingBytesTx;          ///< Number of padding bytes sent.
+        argos::UInt64 m_numMultiplexedTx;           ///< Number of packets sent that carried several messages.
+        argos::UInt64 m_numMsgsRx[MSG_TYPE_COUNT];  ///< Type => Number of messages of that type received.
+        argos::UInt64 m_numAllocations;             ///< Number of times a buffer of the messenger grew.
+
+        // Outgoing messages of the current timestep.
+        std::vector<argos::UInt8> m_txQueues[MSG_TYPE_COUNT]; ///< Type => Queued messages, each preceded by its size on two bytes.
+        argos::UInt16 m_txQueuedBytes[MSG_TYPE_COUNT];        ///< Type => Bytes taken in a multiplexed packet.
+        argos::UInt32 m_numTxQueued;                          ///< Number of queued messages.
+        MsgType m_txFirstType;                                ///< Type of the first queued message, which is encoded in m_txBuffer until another one is queued.
+        argos::UInt16 m_txFirstSize;                          ///< Size of the first queued message.
+        TxPolicy m_txPolicies[MSG_TYPE_COUNT];                ///< Type => Packing policy.
+        argos::UInt8 m_txOrder[MSG_TYPE_COUNT];               ///< Types, in the order they are packed.
+
+        argos::CCI_RangeAndBearingSensor::TReadings m_rxUnpacked; ///< Messages unpacked from the multiplexed packets ; kept from one timestep to the next.
+        TrafficTrace::RobotTrace* m_capture; ///< Where the received packets are recorded ; nullptr if they are not.
 
     };
 }
@@ -0,0 +1,166 @@
+#include <algorithm> // std::max
+#include <utility>   // std::move, std::pair
+
+#include "PropagationStats.h"
+
+namespace swlexp {
+    PropagationStats PropagationStats::c_inst;
+    const argos::UInt16 PropagationStats::UNREACHABLE;
+    const argos::UInt32 PropagationStats::NUM_BINS;
+}
+
+static const argos::UInt32 NO_STEP = (argos::UInt32)-1;
+static const argos::UInt32 VERSION = 1;
+
+/**
+ * Writes a value in a binary stream.
+ */
+template <class T>
+static void writeBinary(std::ostream& o, T value) {
+    o.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::PropagationStats::PropagationStats()
+    : m_numRobots(0)
+    , m_step(0)
+{ }
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::init(RobotId numRobots) {
+    m_numRobots = numRobots;
+    m_hopSource = THopSource();
+    m_hops.assign(numRobots, std::vector<argos::UInt16>());
+    m_hopsLeft.assign(numRobots, 0);
+
+    m_originSteps.assign(numRobots, NO_STEP);
+    m_originCount.assign(numRobots, 0);
+    m_originSum  .assign(numRobots, 0);
+    m_originMax  .assign(numRobots, 0);
+    m_originBins .assign(numRobots * NUM_BINS, 0);
+    // Only the UNREACHABLE row, until longer distances are recorded.
+    m_hopCount   .assign(1, 0);
+    m_hopSum     .assign(1, 0);
+    m_hopBins    .assign(NUM_BINS, 0);
+    for (Buffer& buffer : m_buffers) {
+        buffer.reaches.clear();
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::setHopSource(THopSource hopSource) {
+    m_hopSource = std::move(hopSource);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::merge() {
+    if (m_numRobots == 0) {
+        return;
+    }
+    for (Buffer& buffer : m_buffers) {
+        for (const std::pair<RobotId, RobotId>& reach : buffer.reaches) {
+            _add(reach.first, reach.second);
+        }
+        buffer.reaches.clear();
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::_record(RobotId origin, RobotId receiver) {
+    Buffer& buffer = m_buffers[ShardedCounter::getShard()];
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.reaches.emplace_back(origin, receiver);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::_add(RobotId origin, RobotId receiver) {
+    if (m_originSteps[origin] == NO_STEP) {
+        return;
+    }
+    const argos::UInt32 LATENCY = m_step - m_originSteps[origin];
+    const argos::UInt32 BIN     = (LATENCY == 0) ? 0 : 32 - __builtin_clz(LATENCY);
+
+    ++m_originCount[origin];
+    m_originSum[origin] += LATENCY;
+    m_originMax[origin]  = std::max(m_originMax[origin], LATENCY);
+    ++m_originBins[origin * NUM_BINS + BIN];
+
+    const argos::UInt16 HOPS = _getHops(origin, receiver);
+    const argos::UInt32 UNREACHABLE_ROW = m_hopCount.size() - 1;
+    if (HOPS != UNREACHABLE && HOPS >= UNREACHABLE_ROW) {
+        // Insert the rows up to that distance before the UNREACHABLE row.
+        const argos::UInt32 NUM_NEW_ROWS = HOPS + 1 - UNREACHABLE_ROW;
+        m_hopCount.insert(m_hopCount.begin() + UNREACHABLE_ROW, NUM_NEW_ROWS, 0);
+        m_hopSum  .insert(m_hopSum.begin()   + UNREACHABLE_ROW, NUM_NEW_ROWS, 0);
+        m_hopBins .insert(m_hopBins.begin()  + UNREACHABLE_ROW * NUM_BINS, NUM_NEW_ROWS * NUM_BINS, 0);
+    }
+    const argos::UInt32 ROW = (HOPS == UNREACHABLE) ? m_hopCount.size() - 1 : HOPS;
+    ++m_hopCount[ROW];
+    m_hopSum[ROW] += LATENCY;
+    ++m_hopBins[ROW * NUM_BINS + BIN];
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt16 swlexp::PropagationStats::_getHops(RobotId origin, RobotId receiver) {
+    if (!m_hopSource) {
+        return UNREACHABLE;
+    }
+    std::vector<argos::UInt16>& hops = m_hops[origin];
+    if (hops.empty()) {
+        hops.resize(m_numRobots);
+        m_hopSource(origin, hops.data());
+        m_hopsLeft[origin] = 0;
+        for (RobotId robot = 0; robot < m_numRobots; ++robot) {
+            if (robot != origin && hops[robot] != UNREACHABLE) {
+                ++m_hopsLeft[origin];
+            }
+        }
+    }
+    const argos::UInt16 HOPS = hops[receiver];
+    // Once the origin reached every robot it can, its distances are not
+    // needed anymore.
+    if (HOPS != UNREACHABLE && receiver != origin && --m_hopsLeft[origin] == 0) {
+        std::vector<argos::UInt16>().swap(hops);
+    }
+    return HOPS;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::PropagationStats::write(std::ostream& o) const {
+    o.write("SWPS", 4);
+    writeBinary<argos::UInt32>(o, VERSION);
+    writeBinary<argos::UInt32>(o, m_numRobots);
+    writeBinary<argos::UInt32>(o, NUM_BINS);
+    writeBinary<argos::UInt32>(o, m_hopCount.size());
+
+    for (RobotId origin = 0; origin < m_numRobots; ++origin) {
+        writeBinary<argos::UInt32>(o, m_originSteps[origin]);
+        writeBinary<argos::UInt32>(o, m_originCount[origin]);
+        writeBinary<argos::UInt64>(o, m_originSum[origin]);
+        writeBinary<argos::UInt32>(o, m_originMax[origin]);
+        o.write(reinterpret_cast<const char*>(&m_originBins[origin * NUM_BINS]),
+                NUM_BINS * sizeof(argos::UInt32));
+    }
+    for (argos::UInt32 row = 0; row < m_hopCount.size(); ++row) {
+        writeBinary<argos::UInt32>(o, m_hopCount[row]);
+        writeBinary<argos::UInt64>(o, m_hopSum[row]);
+        o.write(reinterpret_cast<const char*>(&m_hopBins[row * NUM_BINS]),
+                NUM_BINS * sizeof(argos::UInt32));
+    }
+}
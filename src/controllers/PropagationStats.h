@@ -0,0 +1,220 @@
+/**
+ * @file PropagationStats.h
+ * @brief Definition of the PropagationStats class.
+ */
+
+#ifndef PROPAGATION_STATS_H
+#define PROPAGATION_STATS_H
+
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "include.h"
+#include "ShardedCounter.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Distributions of the time it takes for the entry of a robot
+     * to first reach the other robots.
+     * @details The latency of a first reach is the number of steps between
+     * the creation of the origin's entry and the creation of its entry in
+     * the receiver's swarmlist. Latencies are accumulated in histograms
+     * with logarithmic bins, both per origin and per hop distance between
+     * the origin and the receiver ; no per-pair data is kept, besides the
+     * hop distances from the origins that are still reaching robots.
+     *
+     * Binary output, in host byte order:
+     * - Header: "SWPS", UInt32 version, UInt32 number of robots 'N',
+     *   UInt32 number of bins 'B', UInt32 number of hop rows 'H'.
+     * - For each of the N origins: UInt32 step at which its entry was
+     *   created (0xFFFFFFFF if never), UInt32 number of robots reached,
+     *   UInt64 sum of the latencies, UInt32 highest latency, then B UInt32
+     *   bins.
+     * - For each of the H hop distances: UInt32 number of first reaches,
+     *   UInt64 sum of the latencies, then B UInt32 bins. The last row is
+     *   for the receivers that the origin cannot reach in the neighbour
+     *   graph.
+     *
+     * Bin 0 holds the latencies of 0 ; bin 'b' holds the latencies
+     * in [2^(b-1),2^b).
+     *
+     * The controllers may record first reaches from several threads,
+     * during a step. Each thread appends them to its own buffer, indexed
+     * like the shards of ShardedCounter ; the buffers are merged into the
+     * distributions by merge(), between two steps. Origins are recorded
+     * between two steps too.
+     */
+    class PropagationStats {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Computes the hop distances from an origin to every robot.
+         * @param[in] origin The origin.
+         * @param[out] hops Robot ID => Hop distance from the origin, or
+         * UNREACHABLE ; it has room for every robot.
+         */
+        typedef std::function<void(RobotId origin, argos::UInt16* hops)> THopSource;
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        PropagationStats();
+
+        /**
+         * @brief Starts recording.
+         * @details Robots whose IDs are not in [0,numRobots) are ignored.
+         * Until setHopSource() is called, every pair of robots is counted
+         * as UNREACHABLE.
+         * @param[in] numRobots The number of robots.
+         */
+        void init(RobotId numRobots);
+
+        /**
+         * Sets how the hop distances used to classify the first reaches
+         * are computed. The distances from an origin are computed at its
+         * first reach, and dropped once it reached every robot it can.
+         * @param[in] hopSource Computes the hop distances from an origin ;
+         * it must stay valid until the next call to init().
+         */
+        void setHopSource(THopSource hopSource);
+
+        /**
+         * Sets the current step.
+         */
+        inline
+        void setStep(argos::UInt32 step) { m_step = step; }
+
+        /**
+         * Records that the entry of a robot was created in its own swarmlist.
+         * @param[in] origin The robot.
+         */
+        inline
+        void recordOrigin(RobotId origin)
+        { if (origin < m_numRobots) m_originSteps[origin] = m_step; }
+
+        /**
+         * Records that the entry of a robot was created in the swarmlist of
+         * another robot.
+         * @param[in] origin The robot whose entry was received.
+         * @param[in] receiver The robot that received the entry.
+         */
+        inline
+        void recordFirstReach(RobotId origin, RobotId receiver)
+        { if (origin < m_numRobots && receiver < m_numRobots) _record(origin, receiver); }
+
+        /**
+         * Adds the first reaches recorded since the last call to the
+         * distributions. This must be called after every step, before the
+         * step is changed, and from a single thread.
+         */
+        void merge();
+
+        /**
+         * Writes the distributions, as of the last call to merge().
+         * @param[out] o The binary stream to write to.
+         */
+        void write(std::ostream& o) const;
+
+    private:
+
+        /**
+         * Records a first reach in the buffer of the calling thread ;
+         * both robots are known to be in range.
+         * @see recordFirstReach()
+         */
+        void _record(RobotId origin, RobotId receiver);
+
+        /**
+         * Adds a first reach to the distributions.
+         * @see merge()
+         */
+        void _add(RobotId origin, RobotId receiver);
+
+        /**
+         * Gets the hop distance between two robots, computing the hop
+         * distances from the origin if needed.
+         */
+        argos::UInt16 _getHops(RobotId origin, RobotId receiver);
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Instance getter.
+         */
+        inline static
+        PropagationStats& getInst() { return c_inst; }
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    private:
+
+        /**
+         * First reaches recorded by the threads of a shard, alone on its
+         * cache line. When there are more threads than shards, some
+         * threads share a buffer ; the lock is otherwise uncontended.
+         */
+        struct alignas(64) Buffer {
+            std::mutex mutex;
+            std::vector<std::pair<RobotId, RobotId>> reaches; ///< (Origin, Receiver) pairs.
+        };
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    public:
+
+        static const argos::UInt16 UNREACHABLE = (argos::UInt16)-1; ///< Hop distance of robots that cannot reach each other.
+        static const argos::UInt32 NUM_BINS    = 33;                ///< Number of bins of a histogram.
+
+    private:
+
+        static PropagationStats c_inst; ///< Instance.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        RobotId m_numRobots;                      ///< Number of robots recorded ; 0 when disabled.
+        argos::UInt32 m_step;                     ///< Current step.
+        THopSource m_hopSource;                   ///< Computes the hop distances from an origin ; empty if not set.
+        std::vector<std::vector<argos::UInt16>> m_hops; ///< Origin => Receiver => Hop distance ; empty if not computed, or not needed anymore.
+        std::vector<argos::UInt32> m_hopsLeft;    ///< Origin => Number of reachable robots not reached yet.
+
+        std::vector<argos::UInt32> m_originSteps; ///< Origin => Step at which its entry was created.
+        std::vector<argos::UInt32> m_originCount; ///< Origin => Number of robots reached.
+        std::vector<argos::UInt64> m_originSum;   ///< Origin => Sum of the latencies.
+        std::vector<argos::UInt32> m_originMax;   ///< Origin => Highest latency.
+        std::vector<argos::UInt32> m_originBins;  ///< Origin*NUM_BINS+Bin => Number of first reaches.
+
+        std::vector<argos::UInt32> m_hopCount;    ///< Hops => Number of first reaches ; the last row is for UNREACHABLE.
+        std::vector<argos::UInt64> m_hopSum;      ///< Hops => Sum of the latencies.
+        std::vector<argos::UInt32> m_hopBins;     ///< Hops*NUM_BINS+Bin => Number of first reaches.
+
+        Buffer m_buffers[ShardedCounter::NUM_SHARDS]; ///< Shard => First reaches not merged yet.
+
+    };
+
+}
+
+#endif // !PROPAGATION_STATS_H
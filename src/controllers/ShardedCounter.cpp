@@ -0,0 +1,36 @@
+#include "ShardedCounter.h"
+
+namespace swlexp {
+    const argos::UInt32 ShardedCounter::NUM_SHARDS;
+    std::atomic<argos::UInt32> ShardedCounter::c_nextShard(0);
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::ShardedCounter::ShardedCounter() {
+    for (Shard& shard : m_shards) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+argos::SInt64 swlexp::ShardedCounter::get() const {
+    argos::SInt64 sum = 0;
+    for (const Shard& shard : m_shards) {
+        sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt32 swlexp::ShardedCounter::getShard() {
+    // Threads are given shards in turn, the first time they need one.
+    static thread_local argos::UInt32 shard =
+        c_nextShard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+    return shard;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file ShardedCounter.h
+ * @brief Definition of the ShardedCounter class.
+ */
+
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include <atomic>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Counter that the controllers can change from several threads.
+     * @details Each thread adds to its own shard, on its own cache line,
+     * so that the threads do not contend. The shards are only summed when
+     * the counter is read, i.e., by the loop functions, between two
+     * control steps. When there are more threads than shards, some
+     * threads share a shard, which stays correct since the shards are
+     * atomic.
+     */
+    class ShardedCounter {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        ShardedCounter();
+
+        /**
+         * Adds a value to the counter.
+         * @param[in] delta The value to add ; it may be negative.
+         */
+        inline
+        void add(argos::SInt64 delta)
+        { m_shards[getShard()].value.fetch_add(delta, std::memory_order_relaxed); }
+
+        /**
+         * Sums the shards.
+         * @return The value of the counter.
+         */
+        argos::SInt64 get() const;
+
+    private:
+
+        ShardedCounter(const ShardedCounter&) = delete;
+        ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Determines the shard of the calling thread, in [0,NUM_SHARDS).
+         * Other per-thread data may be indexed by it too.
+         */
+        static
+        argos::UInt32 getShard();
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    private:
+
+        /**
+         * Part of the counter, alone on its cache line.
+         */
+        struct alignas(64) Shard {
+            std::atomic<argos::SInt64> value;
+        };
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    public:
+
+        static const argos::UInt32 NUM_SHARDS = 64; ///< Number of shards.
+
+    private:
+
+        static std::atomic<argos::UInt32> c_nextShard; ///< Shard of the next thread to change a counter.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        Shard m_shards[NUM_SHARDS]; ///< Shards of the counter.
+
+    };
+
+}
+
+#endif // !SHARDED_COUNTER_H
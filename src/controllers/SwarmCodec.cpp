@@ -0,0 +1,44 @@
+#include <stdexcept> // std::domain_error
+#include <string>
+
+#include "SwarmCodec.h"
+
+/****************************************/
+/****************************************/
+
+/**
+ * Gets the codec of some robot ID type, given the size of the Lamport clocks.
+ */
+template <class IdType>
+static const swlexp::SwarmCodec* getWithIdType(argos::UInt8 lamportSize) {
+    static const swlexp::SwarmCodecImpl<IdType, argos::UInt8 > CODEC_8;
+    static const swlexp::SwarmCodecImpl<IdType, argos::UInt16> CODEC_16;
+    static const swlexp::SwarmCodecImpl<IdType, argos::UInt32> CODEC_32;
+    switch (lamportSize) {
+        case 1:  return &CODEC_8;
+        case 2:  return &CODEC_16;
+        case 4:  return &CODEC_32;
+        default: return nullptr;
+    }
+}
+
+/****************************************/
+/****************************************/
+
+const swlexp::SwarmCodec& swlexp::SwarmCodec::get(argos::UInt8 robotIdSize,
+                                                  argos::UInt8 lamportSize) {
+    const SwarmCodec* codec;
+    switch (robotIdSize) {
+        case 1:  codec = getWithIdType<argos::UInt8 >(lamportSize); break;
+        case 2:  codec = getWithIdType<argos::UInt16>(lamportSize); break;
+        case 4:  codec = getWithIdType<argos::UInt32>(lamportSize); break;
+        default: codec = nullptr;
+    }
+    if (codec == nullptr) {
+        throw std::domain_error(
+            "Unsupported swarm message format: " +
+            std::to_string(robotIdSize) + "-byte robot IDs and " +
+            std::to_string(lamportSize) + "-byte Lamport clocks.");
+    }
+    return *codec;
+}
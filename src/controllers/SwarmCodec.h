@@ -0,0 +1,121 @@
+/**
+ * @file SwarmCodec.h
+ * @brief Definition of the SwarmCodec classes.
+ */
+
+#ifndef SWARM_CODEC_H
+#define SWARM_CODEC_H
+
+#include "include.h"
+#include "SwarmPacketView.h"
+
+namespace swlexp {
+
+    /**
+     * Wire format of the swarmlist entries inside a swarm message.
+     * An encoded entry is made of a robot ID, a swarm mask and a
+     * Lamport clock, in that order. The widths of the robot ID and of the
+     * Lamport clock depend on the concrete codec. The entries themselves
+     * are encoded and decoded through the views of SwarmCodecImpl, by
+     * loops instantiated once per format, so that no call is made per
+     * entry.
+     */
+    class SwarmCodec {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        virtual
+        ~SwarmCodec() {}
+
+        /**
+         * Determines the size, in bytes, of an encoded entry.
+         */
+        virtual
+        argos::UInt16 getEntrySize() const = 0;
+
+        /**
+         * Determines the size, in bytes, of an encoded robot ID.
+         */
+        virtual
+        argos::UInt8 getRobotIdSize() const = 0;
+
+        /**
+         * Determines the size, in bytes, of an encoded Lamport clock.
+         */
+        virtual
+        argos::UInt8 getLamportSize() const = 0;
+
+        /**
+         * Determines the largest robot ID that can be encoded.
+         */
+        virtual
+        RobotId getMaxRobotId() const = 0;
+
+        /**
+         * Determines which Lamport clocks of a batch are newer than others,
+         * at the width of the encoded clocks.
+         * @see newerLamportMask()
+         */
+        virtual
+        argos::UInt64 isNewer(const Lamport32* lamports,
+                              const Lamport32* others,
+                              argos::UInt32 num) const = 0;
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Gets the codec for some robot ID and Lamport clock sizes.
+         * @throw std::domain_error The sizes are not 1, 2 or 4 bytes.
+         * @param[in] robotIdSize The size, in bytes, of an encoded robot ID.
+         * @param[in] lamportSize The size, in bytes, of an encoded Lamport clock.
+         * @return The codec.
+         */
+        static
+        const SwarmCodec& get(argos::UInt8 robotIdSize, argos::UInt8 lamportSize);
+
+    };
+
+    /**
+     * Wire format whose robot IDs and Lamport clocks are of some
+     * unsigned integer types.
+     */
+    template <class IdType, class LamportType>
+    class SwarmCodecImpl : public SwarmCodec {
+
+    public:
+
+        typedef SwarmPacketView<IdType, LamportType>                     View;      ///< View of a swarm message to encode.
+        typedef SwarmPacketView<IdType, LamportType, const argos::UInt8> ConstView; ///< View of a swarm message to decode.
+
+        virtual
+        argos::UInt16 getEntrySize() const { return View::ENTRY_SIZE; }
+
+        virtual
+        argos::UInt8 getRobotIdSize() const { return sizeof(IdType); }
+
+        virtual
+        argos::UInt8 getLamportSize() const { return sizeof(LamportType); }
+
+        virtual
+        RobotId getMaxRobotId() const { return static_cast<IdType>(-1); }
+
+        virtual
+        argos::UInt64 isNewer(const Lamport32* lamports,
+                              const Lamport32* others,
+                              argos::UInt32 num) const {
+            return newerLamportMask(lamports, others, num, static_cast<LamportType>(-1));
+        }
+
+    };
+
+}
+
+#endif // !SWARM_CODEC_H
@@ -0,0 +1,153 @@
+/**
+ * @file SwarmPacketView.h
+ * @brief Definition of the SwarmPacketView class.
+ */
+
+#ifndef SWARM_PACKET_VIEW_H
+#define SWARM_PACKET_VIEW_H
+
+#include <cstring> // std::memcpy
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * Reads a value at any position of a buffer.
+     * The copy compiles to a single move on targets that allow unaligned
+     * accesses, and stays well-defined on the others.
+     * @param[in] src Where the value is.
+     * @return The value.
+     */
+    template <class T>
+    inline
+    T loadUnaligned(const argos::UInt8* src) {
+        T value;
+        std::memcpy(&value, src, sizeof(T));
+        return value;
+    }
+
+    /**
+     * Writes a value at any position of a buffer.
+     * @param[out] dst Where to write the value.
+     * @param[in] value The value.
+     * @see loadUnaligned()
+     */
+    template <class T>
+    inline
+    void storeUnaligned(argos::UInt8* dst, T value) {
+        std::memcpy(dst, &value, sizeof(T));
+    }
+
+    /**
+     * @brief Typed access to the entries of a swarm message, in place.
+     * @details A swarm message is made of the message type, then of
+     * entries that are each a robot ID, a swarm mask and a Lamport clock,
+     * without padding. The fields are read and written with
+     * loadUnaligned() and storeUnaligned() at offsets known at compile
+     * time.
+     * ByteType is 'const argos::UInt8' for a read-only view.
+     */
+    template <class IdType, class LamportType, class ByteType = argos::UInt8>
+    class SwarmPacketView {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        /**
+         * Class constructor.
+         * @param[in] data The first byte of the packet, i.e., the message type.
+         */
+        explicit
+        SwarmPacketView(ByteType* data) : m_data(data) {}
+
+        /**
+         * Gets the robot ID of an entry.
+         */
+        inline
+        IdType getRobotId(argos::UInt16 idx) const
+        { return loadUnaligned<IdType>(&m_data[getEntryPos(idx) + ROBOT_ID_POS]); }
+
+        /**
+         * Gets the swarm mask of an entry.
+         */
+        inline
+        argos::UInt8 getSwarmMask(argos::UInt16 idx) const
+        { return m_data[getEntryPos(idx) + SWARM_MASK_POS]; }
+
+        /**
+         * Gets the Lamport clock of an entry.
+         */
+        inline
+        LamportType getLamport(argos::UInt16 idx) const
+        { return loadUnaligned<LamportType>(&m_data[getEntryPos(idx) + LAMPORT_POS]); }
+
+        /**
+         * Sets an entry.
+         * @param[in] idx The index of the entry.
+         * @param[in] robot The robot ID.
+         * @param[in] swarmMask The swarm mask.
+         * @param[in] lamport The Lamport clock.
+         */
+        inline
+        void setEntry(argos::UInt16 idx,
+                      IdType robot,
+                      argos::UInt8 swarmMask,
+                      LamportType lamport) const {
+            argos::UInt8* entry = &m_data[getEntryPos(idx)];
+            storeUnaligned<IdType>(&entry[ROBOT_ID_POS], robot);
+            entry[SWARM_MASK_POS] = swarmMask;
+            storeUnaligned<LamportType>(&entry[LAMPORT_POS], lamport);
+        }
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Determines the offset, inside the packet, of an entry.
+         */
+        inline static constexpr
+        argos::UInt16 getEntryPos(argos::UInt16 idx) { return HEADER_SIZE + ENTRY_SIZE * idx; }
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    public:
+
+        static constexpr argos::UInt16 HEADER_SIZE    = 1;                                          ///< Size of the message type.
+        static constexpr argos::UInt16 ROBOT_ID_POS   = 0;                                          ///< Offset, inside an entry, of the robot's ID.
+        static constexpr argos::UInt16 SWARM_MASK_POS = sizeof(IdType);                             ///< Offset, inside an entry, of the swarm mask.
+        static constexpr argos::UInt16 LAMPORT_POS    = sizeof(IdType) + sizeof(argos::UInt8);      ///< Offset, inside an entry, of the Lamport clock.
+        static constexpr argos::UInt16 ENTRY_SIZE     = LAMPORT_POS + sizeof(LamportType);          ///< Size of an entry.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        ByteType* m_data; ///< First byte of the packet.
+
+    };
+
+    template <class IdType, class LamportType, class ByteType>
+    constexpr argos::UInt16 SwarmPacketView<IdType, LamportType, ByteType>::HEADER_SIZE;
+    template <class IdType, class LamportType, class ByteType>
+    constexpr argos::UInt16 SwarmPacketView<IdType, LamportType, ByteType>::ROBOT_ID_POS;
+    template <class IdType, class LamportType, class ByteType>
+    constexpr argos::UInt16 SwarmPacketView<IdType, LamportType, ByteType>::SWARM_MASK_POS;
+    template <class IdType, class LamportType, class ByteType>
+    constexpr argos::UInt16 SwarmPacketView<IdType, LamportType, ByteType>::LAMPORT_POS;
+    template <class IdType, class LamportType, class ByteType>
+    constexpr argos::UInt16 SwarmPacketView<IdType, LamportType, ByteType>::ENTRY_SIZE;
+
+}
+
+#endif // !SWARM_PACKET_VIEW_H
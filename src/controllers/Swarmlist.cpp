@@ -1,50 +1,93 @@
+#include <argos3/core/utility/math/rng.h> // argos::CRandom
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
 #include <cinttypes>
 #include <sstream>
-#include <random> // std::default_random_engine
+#include <random> // std::default_random_engine, std::mt19937, std::seed_seq, std::uniform_int_distribution
 #include <chrono> // std::chrono
-#include <argos3/core/utility/math/rng.h> // argos::CRandom
 
+#include "PropagationStats.h"
 #include "Swarmlist.h"
 
 namespace swlexp {
     argos::UInt32       Swarmlist::Entry::c_ticksToInactive = 1;
 
     bool                Swarmlist::c_entriesShouldBecomeInactive;
-    argos::UInt64       Swarmlist::c_totalNumActive = 0;
+    ShardedCounter      Swarmlist::c_totalNumActive;
     argos::UInt16       Swarmlist::c_numEntriesPerSwarmMsg;
-    const argos::UInt16 Swarmlist::c_SWARM_ENTRY_SIZE = sizeof(RobotId) + sizeof(argos::UInt8) + sizeof(Lamport32);
-    const argos::UInt8  Swarmlist::c_ROBOT_ID_POS     = 0;
-    const argos::UInt8  Swarmlist::c_SWARM_MASK_POS   = 0 + sizeof(RobotId);
-    const argos::UInt8  Swarmlist::c_LAMPORT_POS      = 0 + sizeof(RobotId) + sizeof(argos::UInt8);
+    const SwarmCodec*   Swarmlist::c_codec            = &SwarmCodec::get(sizeof(RobotId), sizeof(Lamport32));
+    argos::UInt32       Swarmlist::c_lamportMask      = (argos::UInt32)-1;
+    Swarmlist::TDecodeSwarmEntries Swarmlist::c_decodeSwarmEntries =
+        &Swarmlist::_decodeSwarmEntries<RobotId, argos::UInt32>;
+    Swarmlist::TFillSwarmMessage   Swarmlist::c_fillSwarmMessage   =
+        &Swarmlist::_fillSwarmMessage<RobotId, argos::UInt32>;
+    Swarmlist::SchedulingPolicy Swarmlist::c_schedulingPolicy = Swarmlist::SCHEDULING_ROUND_ROBIN;
+    argos::UInt32       Swarmlist::c_hotQueueSize     = 32;
+    argos::UInt32       Swarmlist::c_digestPeriod     = 0;
+    argos::UInt32       Swarmlist::c_numDigestBuckets = 1;
+    Swarmlist::ConsensusTemplate Swarmlist::c_consensus = {};
+    const argos::UInt32 Swarmlist::c_STAMP_MASK       = (1u << 24) - 1;
+    const argos::UInt32 Swarmlist::c_NO_ENTRY         = (argos::UInt32)-1;
     }
 
+/**
+ * Hashes an (ID,Lamport clock) pair for the digests.
+ */
+static inline
+argos::UInt32 digestHash(swlexp::RobotId robot, argos::UInt32 lamport) {
+    argos::UInt64 x = ((argos::UInt64)robot << 32) | lamport;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (argos::UInt32)x;
+}
+
 /****************************************/
 /****************************************/
 
 swlexp::Swarmlist::Swarmlist(Messenger* msn)
-    : m_msn(msn)
+    : m_denseIdBound(0)
+    , m_msn(msn)
     , m_swMsgCb(this)
+    , m_digestMsgCb(this)
 {
     m_numActive = 0;
+    // The callback classes are final ; the messenger calls them directly.
     m_msn->registerCallback(Messenger::MSG_TYPE_SWARM, m_swMsgCb);
+    m_msn->registerCallback(Messenger::MSG_TYPE_DIGEST, m_digestMsgCb);
+    // When a digest and a swarm message share a packet, the digest goes
+    // first ; the swarm message takes the rest.
+    m_msn->setTxPolicy(Messenger::MSG_TYPE_DIGEST, 0, 0);
+    m_msn->setTxPolicy(Messenger::MSG_TYPE_SWARM, 1, 0);
 }
 
 /****************************************/
 /****************************************/
 
 swlexp::Swarmlist::~Swarmlist() {
-    c_totalNumActive -= m_numActive;
+    c_totalNumActive.add(-(argos::SInt64)m_numActive);
     m_msn->removeCallback(Messenger::MSG_TYPE_SWARM, m_swMsgCb);
+    m_msn->removeCallback(Messenger::MSG_TYPE_DIGEST, m_digestMsgCb);
 }
 
 /****************************************/
 /****************************************/
 
-void swlexp::Swarmlist::init(RobotId id) {
+void swlexp::Swarmlist::init(RobotId id, RobotId denseIdBound) {
+    if (id > c_codec->getMaxRobotId()) {
+        throw std::domain_error(
+            "Robot ID " + std::to_string(id) + " does not fit in " +
+            std::to_string(c_codec->getRobotIdSize()) + " bytes.");
+    }
     m_id = id;
+    m_denseIdBound = denseIdBound;
+    // Derive our random numbers from the seed of the run and our ID, so
+    // that they do not depend on the order in which the swarmlists are
+    // created, nor change the numbers drawn by the simulator.
+    std::seed_seq seed = { argos::CRandom::GetCategory("argos").GetSeed(), id };
+    m_rng.seed(seed);
     reset();
 }
 
@@ -52,23 +95,64 @@ void swlexp::Swarmlist::init(RobotId id) {
 /****************************************/
 
 void swlexp::Swarmlist::reset() {
-    m_data.clear();
+    const PackedEntry EMPTY = { 0, 0, 0 };
+    m_entries.clear();
+    m_flags.clear();
+    m_ids.clear();
+    m_expiries.clear();
+    m_ring.clear();
+    m_pending.clear();
     m_idToIndex.clear();
-    m_data.shrink_to_fit();
+    m_entries.shrink_to_fit();
+    m_flags.shrink_to_fit();
+    m_ids.shrink_to_fit();
+    m_expiries.shrink_to_fit();
+    m_ring.shrink_to_fit();
+    m_pending.shrink_to_fit();
+    m_hot.assign(c_hotQueueSize, c_NO_ENTRY);
+    // The entries of the robots whose ID is dense are preallocated.
+    m_entries.resize(m_denseIdBound, EMPTY);
+    m_flags.resize(m_denseIdBound, 0);
+    m_ring.reserve(m_denseIdBound);
 
     // Reinitialize stuff
-    c_totalNumActive -= m_numActive;
+    c_totalNumActive.add(-(argos::SInt64)m_numActive);
     m_numActive       = 0;
+    m_numEntries      = 0;
+    m_expiryFront     = 0;
     m_next            = 0;
+    m_hotFront        = 0;
+    m_numHot          = 0;
     m_numMsgsTx       = 0;
     m_numMsgsRx       = 0;
+    m_numEntriesRx    = 0;
+    m_numUsefulEntriesRx    = 0;
+    m_numDuplicateEntriesRx = 0;
     m_highestTti      = 0;
     m_ttiSum          = 0;
     m_numUpdates      = 0;
+    m_step            = 0;
 
     c_numEntriesPerSwarmMsg =
-        (getPacketSize() - 1) /
-        (sizeof(RobotId) + sizeof(argos::UInt8) + sizeof(Lamport32));
+        (getPacketSize() - 1) / c_codec->getEntrySize();
+    m_rxStoredIdx.resize(LAMPORT_BATCH_SIZE);
+    m_rxStoredLamports.resize(LAMPORT_BATCH_SIZE, Lamport32(0));
+
+    _updateNumDigestBuckets();
+    m_digest.assign(c_numDigestBuckets, 0);
+    m_digestMismatches = 0;
+    m_pendingFront     = 0;
+    // Spread the digests of the robots over the period.
+    m_stepsToDigest = (c_digestPeriod > 0) ? 1 + m_id % c_digestPeriod : 0;
+    // In anti-entropy mode, when entries expire, our own entry is refreshed
+    // often enough for our neighbours to keep it active.
+    if (c_digestPeriod > 0 && c_entriesShouldBecomeInactive &&
+        Entry::getTicksToInactive() != (argos::UInt32)-1) {
+        m_stepsToRefresh = 1 + m_id % _getOwnRefreshPeriod();
+    }
+    else {
+        m_stepsToRefresh = 0;
+    }
 
     _update(m_id, 0, 0);
 }
@@ -84,29 +168,156 @@ void swlexp::Swarmlist::controlStep() {
 /****************************************/
 /****************************************/
 
-void swlexp::Swarmlist::forceConsensus(const std::vector<RobotId>& existingRobots) {
-    static argos::CRandom::CRNG* argosRng = argos::CRandom::CreateRNG("argos");
+void swlexp::Swarmlist::forceConsensus() {
+    if (!c_consensus.isPrepared || c_consensus.denseIdBound != m_denseIdBound) {
+        throw std::logic_error("No consensus template for a dense ID bound of " +
+                               std::to_string(m_denseIdBound) + ".");
+    }
     reset();
 
-    // Make a vector containing the id of all robots.
+    // Clone the template in bulk. Our own entry was created by reset(),
+    // and is added back below if the template does not have it.
+    c_totalNumActive.add(-(argos::SInt64)m_numActive);
+    m_entries   = c_consensus.entries;
+    m_flags     = c_consensus.flags;
+    m_ids       = c_consensus.ids;
+    m_idToIndex = c_consensus.idToIndex;
+    m_ring      = c_consensus.ring;
+    m_digest    = c_consensus.digest;
+    m_numEntries = m_ring.size();
+    m_numActive  = m_ring.size();
+    c_totalNumActive.add(m_numActive);
+
+    const argos::UInt32 OWN_IDX =
+        (m_id < m_denseIdBound) ? m_id : m_idToIndex.find(m_id);
+    if (OWN_IDX == IdIndex::NOT_FOUND || !(m_flags[OWN_IDX] & FLAG_EXISTS)) {
+        _update(m_id, 0, 0);
+    }
+    else {
+        m_ownIdx = OWN_IDX;
+    }
+    for (argos::UInt32 idx : m_ring) {
+        if (idx != m_ownIdx) {
+            _scheduleExpiry(idx);
+        }
+    }
+    m_next = std::uniform_int_distribution<argos::UInt32>(0, m_ring.size() - 1)(m_rng);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::prepareConsensus(const std::vector<RobotId>& existingRobots,
+                                         RobotId denseIdBound) {
+    const PackedEntry EMPTY = { 0, 0, 0 };
+
+    // Shuffle the robots once ; their order in the template is the
+    // order in which every swarmlist will send them. The engine is seeded
+    // from the run's seed rather than drawn from an RNG of the category,
+    // which does not outlive the category.
     std::vector<RobotId> robots = existingRobots;
-    unsigned int seed = argosRng->Uniform(argos::CRange<argos::UInt32>(0, UINT32_MAX));
-    std::default_random_engine rng(seed);
+    std::mt19937 rng(argos::CRandom::GetCategory("argos").GetSeed());
     std::shuffle(robots.begin(), robots.end(), rng);
 
-    for (RobotId id : robots) {
-        if (id != m_id) {
-            _update(id, 0, 0);
+    ConsensusTemplate& tpl = c_consensus;
+    tpl.denseIdBound = denseIdBound;
+    tpl.entries.assign(denseIdBound, EMPTY);
+    tpl.flags.assign(denseIdBound, 0);
+    tpl.ids.clear();
+    tpl.idToIndex.clear();
+    tpl.ring.clear();
+    // The template may be prepared before any swarmlist is reset.
+    _updateNumDigestBuckets();
+    tpl.digest.assign(c_numDigestBuckets, 0);
+
+    for (RobotId robot : robots) {
+        argos::UInt32 idx;
+        bool isNew;
+        if (robot < denseIdBound) {
+            idx   = robot;
+            isNew = !(tpl.flags[idx] & FLAG_EXISTS);
+        }
+        else {
+            idx = tpl.idToIndex.findOrInsert(robot, (argos::UInt32)tpl.entries.size(), isNew);
+            if (isNew) {
+                tpl.entries.push_back(EMPTY);
+                tpl.flags.push_back(0);
+                tpl.ids.push_back(robot);
+            }
         }
+        if (isNew) {
+            tpl.flags[idx] = FLAG_EXISTS | FLAG_ACTIVE | FLAG_IN_RING;
+            tpl.ring.push_back(idx);
+            if (c_digestPeriod > 0) {
+                tpl.digest[_digestBucketOf(robot)] ^= digestHash(robot, 0);
+            }
+        }
+    }
+    tpl.isPrepared = true;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::setWireFormat(argos::UInt8 robotIdSize, argos::UInt8 lamportSize) {
+    c_codec = &SwarmCodec::get(robotIdSize, lamportSize);
+    c_lamportMask = (argos::UInt32)(((argos::UInt64)1 << (8 * lamportSize)) - 1);
+    // The entry loops are picked once here, rather than per entry.
+    switch (robotIdSize) {
+        case 1:  _selectEntryLoops<argos::UInt8 >(lamportSize); break;
+        case 2:  _selectEntryLoops<argos::UInt16>(lamportSize); break;
+        default: _selectEntryLoops<argos::UInt32>(lamportSize);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+template <class IdType>
+void swlexp::Swarmlist::_selectEntryLoops(argos::UInt8 lamportSize) {
+    switch (lamportSize) {
+        case 1:
+            c_decodeSwarmEntries = &Swarmlist::_decodeSwarmEntries<IdType, argos::UInt8>;
+            c_fillSwarmMessage   = &Swarmlist::_fillSwarmMessage  <IdType, argos::UInt8>;
+            break;
+        case 2:
+            c_decodeSwarmEntries = &Swarmlist::_decodeSwarmEntries<IdType, argos::UInt16>;
+            c_fillSwarmMessage   = &Swarmlist::_fillSwarmMessage  <IdType, argos::UInt16>;
+            break;
+        default:
+            c_decodeSwarmEntries = &Swarmlist::_decodeSwarmEntries<IdType, argos::UInt32>;
+            c_fillSwarmMessage   = &Swarmlist::_fillSwarmMessage  <IdType, argos::UInt32>;
     }
-    m_next = argosRng->Uniform(argos::CRange<argos::UInt32>(0, m_data.size()));
 }
 
 /****************************************/
 /****************************************/
 
 void swlexp::Swarmlist::setSwarmMask(argos::UInt8 swarmMask) {
-    m_data[m_idToIndex[m_id]].setSwarmMask(swarmMask);
+    m_entries[m_ownIdx].swarmMask = swarmMask;
+}
+
+/****************************************/
+/****************************************/
+
+size_t swlexp::Swarmlist::getMemoryUsage() const {
+    return sizeof(*this) +
+           m_entries.capacity()     * sizeof(PackedEntry) +
+           m_flags.capacity()       * sizeof(argos::UInt8) +
+           m_ids.capacity()         * sizeof(RobotId) +
+           m_idToIndex.getMemoryUsage() +
+           m_expiries.capacity()    * sizeof(ExpiryRecord) +
+           m_ring.capacity()        * sizeof(argos::UInt32) +
+           m_hot.capacity()         * sizeof(argos::UInt32) +
+           m_digest.capacity()      * sizeof(argos::UInt32) +
+           m_pending.capacity()     * sizeof(argos::UInt32) +
+           m_rxIds.capacity()       * sizeof(RobotId) +
+           m_rxMasks.capacity()     * sizeof(argos::UInt8) +
+           m_rxLamports.capacity()  * sizeof(Lamport32) +
+           m_rxStates.capacity()    * sizeof(argos::UInt8) +
+           m_rxIdToIndex.getMemoryUsage() +
+           m_rxStoredIdx.capacity()      * sizeof(argos::UInt32) +
+           m_rxStoredLamports.capacity() * sizeof(Lamport32);
 }
 
 /****************************************/
@@ -115,22 +326,44 @@ void swlexp::Swarmlist::setSwarmMask(argos::UInt8 swarmMask) {
 std::string swlexp::Swarmlist::serializeData(char elemDelim, char entryDelim) const {
     std::ostringstream sstrm;
 
-    for (const swlexp::Swarmlist::Entry& e : m_data) {
-        sstrm << '(' <<
-                 std::to_string(e.getRobotId())        << elemDelim <<
-                 std::to_string(e.getLamport())        << elemDelim <<
-                 std::to_string(e.getTimeToInactive()) <<
-                 ')' << entryDelim;
+    for (argos::UInt32 i = 0; i < m_entries.size(); ++i) {
+        if (m_flags[i] & FLAG_EXISTS) {
+            sstrm << '(' <<
+                     std::to_string(_robotAt(i))           << elemDelim <<
+                     std::to_string(m_entries[i].lamport)  << elemDelim <<
+                     std::to_string(_getTimeToInactive(i)) <<
+                     ')' << entryDelim;
+        }
     }
 
     return sstrm.str();
 }
 
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::ingest(const argos::CCI_RangeAndBearingSensor::TReadings& readings) {
+    for (const argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
+        if (packet.Data[0] == Messenger::MSG_TYPE_SWARM) {
+            _decodeSwarmMsg(packet);
+        }
+        else if (packet.Data[0] == Messenger::MSG_TYPE_DIGEST) {
+            _decodeDigestMsg(packet);
+        }
+    }
+    _applyReceived();
+    _applyDigestMismatches();
+}
+
 /****************************************/
 /****************************************/
  
-const swlexp::Swarmlist::Entry& swlexp::Swarmlist::_get(RobotId robot) const {
-    return m_data[m_idToIndex.at(robot)];
+swlexp::Swarmlist::Entry swlexp::Swarmlist::_get(RobotId robot) const {
+    const argos::UInt32 IDX = _find(robot);
+    if (IDX == IdIndex::NOT_FOUND) {
+        throw std::out_of_range("No swarmlist entry for robot " + std::to_string(robot) + ".");
+    }
+    return _at(IDX);
 }
 
 /****************************************/
@@ -139,117 +372,312 @@ const swlexp::Swarmlist::Entry& swlexp::Swarmlist::_get(RobotId robot) const {
 void swlexp::Swarmlist::_update(RobotId robot,
                                 argos::UInt8 swarmMask,
                                 Lamport32 lamport) {
-    // Does the entry already exist?
-    const swlexp::Swarmlist::Entry* existingEntry;
-    bool existed;
-    try {
-        existingEntry = &_get(robot);
-        existed = true;
+    // Does the entry already exist? Dense IDs are their own index ;
+    // find the other ones, or reserve a slot for them at the end of the
+    // entries, with a single probe.
+    argos::UInt32 idx;
+    bool isNew;
+    if (robot < m_denseIdBound) {
+        idx   = robot;
+        isNew = !(m_flags[idx] & FLAG_EXISTS);
     }
-    catch (std::out_of_range& err) {
-        existed = false;
+    else {
+        const PackedEntry EMPTY = { 0, 0, 0 };
+        idx = m_idToIndex.findOrInsert(robot, (argos::UInt32)m_entries.size(), isNew);
+        if (isNew) {
+            m_entries.push_back(EMPTY);
+            m_flags.push_back(0);
+            m_ids.push_back(robot);
+        }
     }
+    const argos::UInt32 IDX = idx;
+    PackedEntry& entry = m_entries[IDX];
 
-    bool shouldUpdate;
-    if (existed) {
-        // Yes.
-        Lamport32 oldLamport = existingEntry->getLamport();
-        // Is entry active?
-        if (existingEntry->isActive(m_id)) {
-            // Yes ; use circular lamport clock model to determine
-            // whether the entry should be updated.
-            shouldUpdate = lamport.isNewerThan(oldLamport);
+    if (isNew) {
+        // No ; it's a new entry.
+        entry.lamport   = lamport;
+        entry.swarmMask = swarmMask;
+        entry.stamp     = (argos::UInt32)m_step & c_STAMP_MASK;
+        m_flags[IDX]    = FLAG_EXISTS | FLAG_ACTIVE;
+        if (robot == m_id) {
+            m_ownIdx = IDX;
+            PropagationStats::getInst().recordOrigin(robot);
         }
         else {
-            // No ; the entry is newer if the lamport clocks are different.
-            shouldUpdate = (lamport != oldLamport);
-            if (shouldUpdate) {
-                ++m_numActive;
-                ++c_totalNumActive;
-            }
+            PropagationStats::getInst().recordFirstReach(robot, m_id);
+        }
+        ++m_numEntries;
+        _addToRing(IDX);
+        _toggleInDigest(IDX);
+        if (robot != m_id) {
+            _scheduleExpiry(IDX);
+            _pushHot(IDX);
+            _pushPending(IDX);
+        }
+        ++m_numActive;
+        c_totalNumActive.add(1);
+        return;
+    }
+
+    // Yes.
+    bool shouldUpdate;
+    // Is entry active?
+    if (_isActive(IDX)) {
+        // Yes ; use circular lamport clock model to determine
+        // whether the entry should be updated.
+        shouldUpdate = _isNewer(lamport, entry.lamport);
+    }
+    else {
+        // No ; the entry is newer if the lamport clocks are different.
+        shouldUpdate = (lamport != entry.lamport);
+    }
+    if (shouldUpdate) {
+        _overwrite(IDX, robot, swarmMask, lamport);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_overwrite(argos::UInt32 idx,
+                                   RobotId robot,
+                                   argos::UInt8 swarmMask,
+                                   Lamport32 lamport) {
+    PackedEntry& entry = m_entries[idx];
+
+    // Change the lowest TTI for the statistical analysis.
+    if (robot != m_id) {
+        const argos::UInt32 TTI = -(_getTimeToInactive(idx));
+        m_ttiSum += TTI;
+        ++m_numUpdates;
+        if (TTI > m_highestTti) {
+            m_highestTti = TTI;
         }
     }
+    if (_isActive(idx)) {
+        _toggleInDigest(idx);
+    }
     else {
-        // No ; it's a new entry.
-        shouldUpdate = 1;
+        m_flags[idx] |= FLAG_ACTIVE;
         ++m_numActive;
-        ++c_totalNumActive;
+        c_totalNumActive.add(1);
+        _addToRing(idx);
+    }
+    // Overwrite the entry and reset its timer.
+    entry.swarmMask = swarmMask;
+    entry.lamport   = lamport;
+    entry.stamp     = (argos::UInt32)m_step & c_STAMP_MASK;
+    _toggleInDigest(idx);
+    if (robot != m_id) {
+        _scheduleExpiry(idx);
+        _pushHot(idx);
+        _pushPending(idx);
     }
+}
 
-    if (shouldUpdate) {
-        // Change the lowest TTI for the statistical analysis.
-        if (existed && robot != m_id) {
-            const argos::UInt32 TTI = -(existingEntry->getTimeToInactive());
-            m_ttiSum += TTI;
-            ++m_numUpdates;
-            if (TTI > m_highestTti) {
-                m_highestTti = TTI;
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_decodeSwarmMsg(const argos::CCI_RangeAndBearingSensor::SPacket& packet) {
+    // Messages unpacked from a multiplexed packet may hold fewer entries.
+    const argos::UInt16 NUM_ENTRIES =
+        std::min<argos::UInt16>(c_numEntriesPerSwarmMsg,
+                                (packet.Data.Size() - 1) / c_codec->getEntrySize());
+    (this->*c_decodeSwarmEntries)(packet.Data.ToCArray(), NUM_ENTRIES);
+    m_numEntriesRx += NUM_ENTRIES;
+    m_numMsgsRx += 1;
+}
+
+/****************************************/
+/****************************************/
+
+template <class IdType, class LamportType>
+void swlexp::Swarmlist::_decodeSwarmEntries(const argos::UInt8* swarmMsg, argos::UInt16 numEntries) {
+    const typename SwarmCodecImpl<IdType, LamportType>::ConstView VIEW(swarmMsg);
+    for (argos::UInt16 j = 0; j < numEntries; ++j) {
+        const RobotId ROBOT = VIEW.getRobotId(j);
+        // We have the most updated info about ourself ;
+        // don't update our info.
+        if (ROBOT != m_id) {
+
+            // Keep a single entry per robot.
+            bool isNew;
+            const argos::UInt32 IDX =
+                m_rxIdToIndex.findOrInsert(ROBOT, (argos::UInt32)m_rxIds.size(), isNew);
+            if (isNew) {
+                m_rxIds.push_back(ROBOT);
+                m_rxMasks.push_back(VIEW.getSwarmMask(j));
+                m_rxLamports.push_back(VIEW.getLamport(j));
+                m_rxStates.push_back(RX_UNRESOLVED);
+            }
+            else {
+                ++m_numDuplicateEntriesRx;
+                _mergeDuplicate<LamportType>(IDX, VIEW.getSwarmMask(j), VIEW.getLamport(j));
             }
         }
-        // Create a new entry (which also resets the timer)
-        swlexp::Swarmlist::Entry newEntry =
-            swlexp::Swarmlist::Entry(robot, swarmMask, lamport);
-        _set(newEntry);
     }
 }
 
 /****************************************/
 /****************************************/
 
-void swlexp::Swarmlist::_tick() {
-    if (c_entriesShouldBecomeInactive) {
-        for (argos::UInt32 i = 0; i < m_data.size(); ++i) {
-            // Deal with entries in inactive mode
-            swlexp::Swarmlist::Entry& curr = m_data[i];
-            if (curr.isActive(m_id)) {
-                curr.tick();
-                if (!curr.isActive(m_id)) {
-                    --m_numActive;
-                    --c_totalNumActive;
-                }
-                _set(curr);
+template <class LamportType>
+void swlexp::Swarmlist::_mergeDuplicate(argos::UInt32 rxIdx,
+                                        argos::UInt8 swarmMask,
+                                        Lamport32 lamport) {
+    const argos::UInt32 WIDTH_MASK = static_cast<LamportType>(-1);
+    const argos::UInt32 IDX = _find(m_rxIds[rxIdx]);
+    argos::UInt8& state = m_rxStates[rxIdx];
+    // Apply the earlier entry to the stored one, if not done yet.
+    if (state == RX_UNRESOLVED) {
+        const bool CHANGED = (IDX == IdIndex::NOT_FOUND) ||
+            (_isActive(IDX) ? isNewerLamport(m_rxLamports[rxIdx], m_entries[IDX].lamport, WIDTH_MASK) :
+                              (m_rxLamports[rxIdx] != m_entries[IDX].lamport));
+        state = CHANGED ? RX_CHANGED : RX_UNCHANGED;
+    }
+    // Apply the new entry to the result, like _update() would.
+    const bool CHANGED = (state == RX_CHANGED) ?
+        isNewerLamport(lamport, m_rxLamports[rxIdx], WIDTH_MASK) :
+        (_isActive(IDX) ? isNewerLamport(lamport, m_entries[IDX].lamport, WIDTH_MASK) :
+                          (lamport != m_entries[IDX].lamport));
+    if (CHANGED) {
+        m_rxMasks[rxIdx]    = swarmMask;
+        m_rxLamports[rxIdx] = lamport;
+        state = RX_CHANGED;
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_applyReceived() {
+    const argos::UInt32 NUM_RECEIVED = m_rxIds.size();
+    argos::UInt32* indices = m_rxStoredIdx.data();
+    Lamport32*     stored  = m_rxStoredLamports.data();
+    for (argos::UInt32 first = 0; first < NUM_RECEIVED; first += LAMPORT_BATCH_SIZE) {
+        const argos::UInt32 NUM = std::min<argos::UInt32>(NUM_RECEIVED - first, LAMPORT_BATCH_SIZE);
+
+        // Gather the stored Lamport clocks, and compare them all at once.
+        for (argos::UInt32 j = 0; j < NUM; ++j) {
+            const argos::UInt32 IDX = _find(m_rxIds[first + j]);
+            indices[j] = IDX;
+            stored[j]  = (IDX != IdIndex::NOT_FOUND) ? m_entries[IDX].lamport : 0;
+        }
+        const argos::UInt64 NEWER = c_codec->isNewer(&m_rxLamports[first], stored, NUM);
+
+        for (argos::UInt32 j = 0; j < NUM; ++j) {
+            const argos::UInt32 I = first + j;
+            if (indices[j] == IdIndex::NOT_FOUND) {
+                _update(m_rxIds[I], m_rxMasks[I], m_rxLamports[I]);
+                ++m_numUsefulEntriesRx;
+            }
+            else if (m_rxStates[I] == RX_UNRESOLVED ?
+                     (_isActive(indices[j]) ? ((NEWER >> j) & 1) :
+                                              (m_rxLamports[I] != stored[j])) :
+                     (m_rxStates[I] == RX_CHANGED)) {
+                _overwrite(indices[j], m_rxIds[I], m_rxMasks[I], m_rxLamports[I]);
+                ++m_numUsefulEntriesRx;
             }
         }
     }
+    m_rxIds.clear();
+    m_rxMasks.clear();
+    m_rxLamports.clear();
+    m_rxStates.clear();
+    m_rxIdToIndex.clearKeepingCapacity();
 }
 
 /****************************************/
 /****************************************/
 
-void swlexp::Swarmlist::_set(const swlexp::Swarmlist::Entry& entry) {
-    try {
-        // Get existing entry.
-        argos::UInt32 idx = m_idToIndex.at(entry.getRobotId());
+void swlexp::Swarmlist::_tick() {
+    if (c_entriesShouldBecomeInactive) {
+        ++m_step;
+
+        const argos::UInt32 TICKS_TO_INACTIVE = Entry::getTicksToInactive();
+        while (m_expiryFront < m_expiries.size()) {
+            const ExpiryRecord RECORD = m_expiries[m_expiryFront];
+            if ((argos::UInt32)m_step - RECORD.step < TICKS_TO_INACTIVE) {
+                break;
+            }
+            ++m_expiryFront;
+            // The record is stale if the entry was updated since.
+            if (_isActive(RECORD.idx) &&
+                m_entries[RECORD.idx].stamp == (RECORD.step & c_STAMP_MASK)) {
+                _toggleInDigest(RECORD.idx);
+                m_flags[RECORD.idx] &= ~FLAG_ACTIVE;
+                --m_numActive;
+                c_totalNumActive.add(-1);
+            }
+        }
 
-        // Didn't throw an exception ; the entry already existed.
-        m_data[idx] = entry;
-        m_idToIndex[entry.getRobotId()] = idx;
+        // Drop the expired records once they make up most of the queue.
+        if (m_expiryFront > m_expiries.size() / 2) {
+            m_expiries.erase(m_expiries.begin(), m_expiries.begin() + m_expiryFront);
+            m_expiryFront = 0;
+        }
     }
-    catch (std::out_of_range& e) {
-        // Throwed an exception ; entry doesn't exist yet.
-        m_data.push_back(entry);
-        m_idToIndex[entry.getRobotId()] = (argos::UInt32)m_data.size() - 1;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_scheduleExpiry(argos::UInt32 idx) {
+    // Entries that never expire are not recorded.
+    if (c_entriesShouldBecomeInactive &&
+        Entry::getTicksToInactive() != (argos::UInt32)-1) {
+        const ExpiryRecord RECORD = { idx, (argos::UInt32)m_step };
+        m_expiries.push_back(RECORD);
     }
 }
 
 /****************************************/
 /****************************************/
 
-argos::CByteArray swlexp::Swarmlist::_makeNextMessage() {
-    argos::CByteArray swarmMsg(getPacketSize());
-    swarmMsg[0] = Messenger::MSG_TYPE_SWARM;
+template <class IdType, class LamportType>
+void swlexp::Swarmlist::_fillSwarmMessage(argos::UInt8* swarmMsg, argos::UInt16 numEntries) {
+    // In anti-entropy mode, send the entries that our neighbours may lack
+    // first.
+    argos::UInt16 i = 0;
+    while (m_pendingFront < m_pending.size() && i < numEntries) {
+        const argos::UInt32 IDX = m_pending[m_pendingFront++];
+        m_flags[IDX] &= ~FLAG_PENDING;
+        if (_isActive(IDX)) {
+            _encodeInMessage<IdType, LamportType>(swarmMsg, IDX, i);
+            ++i;
+        }
+    }
+    // Drop the sent entries once they make up most of the queue ; an entry
+    // is queued at most once, so the queue stays within twice the number
+    // of entries.
+    if (m_pendingFront > m_pending.size() / 2) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingFront);
+        m_pendingFront = 0;
+    }
 
-    // Send some entries
-    for (argos::UInt16 i = 0; i < c_numEntriesPerSwarmMsg; ++i) {
-        Entry entry = _getNext();
+    // With the freshness policy, send the recently updated entries first.
+    // The last entry of the message always comes from the round robin, so
+    // that entries that do not change are still refreshed.
+    if (c_schedulingPolicy == SCHEDULING_FRESHNESS) {
+        while (m_numHot > 0 && i + 1 < numEntries) {
+            const argos::UInt32 IDX = _popHot();
+            if (_isActive(IDX)) {
+                _encodeInMessage<IdType, LamportType>(swarmMsg, IDX, i);
+                ++i;
+            }
+        }
+    }
 
-        // Don't send the info of inactive robots.
+    // Send some entries
+    for (; i < numEntries; ++i) {
+        // Don't send the info of inactive robots ; drop them from the
+        // ring, so that each inactive entry is skipped at most once.
         // At worst, only the robot's own data is active,
         // so we don't risk falling in infinite loops.
-        while (!entry.isActive(m_id)) {
-            _next();
-            entry = _getNext();
+        while (!_isActive(m_ring[m_next])) {
+            _removeNextFromRing();
         }
+        const argos::UInt32 IDX = _getNext();
 
         // Go to next robot. If we don't have enough entries, we'll
         // send the same entry several times, but that's OK, since
@@ -257,9 +685,8 @@ argos::CByteArray swlexp::Swarmlist::_makeNextMessage() {
         // Besides, if we have few entries then cost of handling the same
         // entry several times is very low.
         _next();
-        writeInPacket(swarmMsg, entry, i);
+        _encodeInMessage<IdType, LamportType>(swarmMsg, IDX, i);
     }
-    return std::move(swarmMsg);
 }
 
 /****************************************/
@@ -267,10 +694,44 @@ argos::CByteArray swlexp::Swarmlist::_makeNextMessage() {
 
 void swlexp::Swarmlist::_sendSwarmChunk() {
 
+    if (c_digestPeriod > 0) {
+        // When entries expire, our neighbours must regularly hear from us ;
+        // our own entry is sent with the pending ones.
+        if (m_stepsToRefresh > 0 && --m_stepsToRefresh == 0) {
+            m_stepsToRefresh = _getOwnRefreshPeriod();
+            _incrementOwnLamport(m_ownIdx);
+            _pushPending(m_ownIdx);
+        }
+        if (--m_stepsToDigest == 0) {
+            m_stepsToDigest = c_digestPeriod;
+            m_numMsgsTx += 1;
+            _makeDigestMessage(m_msn->queueMsgTx(Messenger::MSG_TYPE_DIGEST,
+                                                 1 + sizeof(argos::UInt32) * c_numDigestBuckets));
+            // Send the entries our neighbours may lack in the same packet,
+            // if there is room left.
+            const argos::UInt16 SPACE = m_msn->getTxSpace(Messenger::MSG_TYPE_SWARM);
+            if (m_pendingFront < m_pending.size() && SPACE >= 1 + c_codec->getEntrySize()) {
+                const argos::UInt16 NUM_ENTRIES =
+                    std::min<argos::UInt16>(c_numEntriesPerSwarmMsg,
+                                            (SPACE - 1) / c_codec->getEntrySize());
+                _makeNextMessage(m_msn->queueMsgTx(Messenger::MSG_TYPE_SWARM,
+                                                   1 + NUM_ENTRIES * c_codec->getEntrySize()),
+                                 NUM_ENTRIES);
+            }
+            return;
+        }
+        if (m_pendingFront == m_pending.size()) {
+            // As far as we know, our neighbours have all our entries.
+            return;
+        }
+    }
+
     // Send several swarm messages
     m_numMsgsTx += 1;
-    // Send a swarm message
-    m_msn->sendMsgTx(std::move(_makeNextMessage()));
+    // Send a swarm message, built in place in the messenger's queue.
+    _makeNextMessage(m_msn->queueMsgTx(Messenger::MSG_TYPE_SWARM,
+                                       1 + c_numEntriesPerSwarmMsg * c_codec->getEntrySize()),
+                     c_numEntriesPerSwarmMsg);
 }
 
 /****************************************/
@@ -278,7 +739,29 @@ void swlexp::Swarmlist::_sendSwarmChunk() {
 
 void swlexp::Swarmlist::_next() {
     ++m_next;
-    if (m_next >= m_data.size()) {
+    if (m_next >= m_ring.size()) {
+        m_next = 0;
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_addToRing(argos::UInt32 idx) {
+    if (!(m_flags[idx] & FLAG_IN_RING)) {
+        m_flags[idx] |= FLAG_IN_RING;
+        m_ring.push_back(idx);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_removeNextFromRing() {
+    m_flags[m_ring[m_next]] &= ~FLAG_IN_RING;
+    m_ring[m_next] = m_ring.back();
+    m_ring.pop_back();
+    if (m_next >= m_ring.size()) {
         m_next = 0;
     }
 }
@@ -286,13 +769,153 @@ void swlexp::Swarmlist::_next() {
 /****************************************/
 /****************************************/
 
-swlexp::Swarmlist::Entry swlexp::Swarmlist::_getNext() {
-    Entry* e = &m_data[m_next];
+void swlexp::Swarmlist::_pushHot(argos::UInt32 idx) {
+    if (c_schedulingPolicy != SCHEDULING_FRESHNESS || (m_flags[idx] & FLAG_IN_HOT) || m_hot.empty()) {
+        return;
+    }
+    if (m_numHot == m_hot.size()) {
+        _popHot();
+    }
+    argos::UInt32 back = m_hotFront + m_numHot;
+    if (back >= m_hot.size()) {
+        back -= m_hot.size();
+    }
+    m_hot[back] = idx;
+    m_flags[idx] |= FLAG_IN_HOT;
+    ++m_numHot;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt32 swlexp::Swarmlist::_popHot() {
+    const argos::UInt32 IDX = m_hot[m_hotFront];
+    m_flags[IDX] &= ~FLAG_IN_HOT;
+    --m_numHot;
+    if (++m_hotFront >= m_hot.size()) {
+        m_hotFront = 0;
+    }
+    return IDX;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt32 swlexp::Swarmlist::_getNext() {
     // Increment our own Lamport clock so that others are aware
     // that we still exist.
-    if (e->getRobotId() == m_id)
-        e->incrementLamport();
-    return *e;
+    // In anti-entropy mode, this is only done periodically, otherwise
+    // every message would trigger more messages.
+    const argos::UInt32 IDX = m_ring[m_next];
+    if (IDX == m_ownIdx && c_digestPeriod == 0)
+        ++m_entries[IDX].lamport;
+    return IDX;
+}
+
+/****************************************/
+/****************************************/
+
+template <class IdType, class LamportType>
+void swlexp::Swarmlist::_encodeInMessage(argos::UInt8* swarmMsg,
+                                         argos::UInt32 idx,
+                                         argos::UInt16 slot) {
+    typename SwarmCodecImpl<IdType, LamportType>::View(swarmMsg).setEntry(
+        slot,
+        static_cast<IdType>(_robotAt(idx)),
+        m_entries[idx].swarmMask,
+        static_cast<LamportType>(m_entries[idx].lamport));
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_incrementOwnLamport(argos::UInt32 idx) {
+    _toggleInDigest(idx);
+    ++m_entries[idx].lamport;
+    _toggleInDigest(idx);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_toggleInDigest(argos::UInt32 idx) {
+    if (c_digestPeriod > 0) {
+        const RobotId ROBOT = _robotAt(idx);
+        m_digest[_digestBucketOf(ROBOT)] ^=
+            digestHash(ROBOT, m_entries[idx].lamport & c_lamportMask);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_pushPending(argos::UInt32 idx) {
+    // Entries that are already queued keep their place.
+    if (c_digestPeriod > 0 && !(m_flags[idx] & FLAG_PENDING)) {
+        m_flags[idx] |= FLAG_PENDING;
+        m_pending.push_back(idx);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_updateNumDigestBuckets() {
+    // Each bucket of a digest message takes 4 bytes, and the differing
+    // buckets are kept in a 32-bit mask. The digest leaves room for a
+    // swarm message of at least one entry in its multiplexed packet,
+    // after the multiplex type and the size of both messages.
+    const argos::SInt32 DIGEST_SPACE =
+        (argos::SInt32)getPacketSize() - 3 - (1 + c_codec->getEntrySize()) - 1;
+    c_numDigestBuckets = (DIGEST_SPACE > 0) ?
+        std::min<argos::UInt32>(DIGEST_SPACE / sizeof(argos::UInt32), 32) : 0;
+    if (c_digestPeriod > 0 && c_numDigestBuckets == 0) {
+        throw std::domain_error("Packets are too small for a digest message and a swarm message.");
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_makeDigestMessage(argos::UInt8* digestMsg) {
+    for (argos::UInt32 b = 0; b < c_numDigestBuckets; ++b) {
+        storeUnaligned<argos::UInt32>(&digestMsg[1+sizeof(argos::UInt32)*b], m_digest[b]);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_decodeDigestMsg(const argos::CCI_RangeAndBearingSensor::SPacket& packet) {
+    // Ignore truncated digests.
+    if (packet.Data.Size() < 1 + sizeof(argos::UInt32) * c_numDigestBuckets) {
+        return;
+    }
+    const argos::UInt8* DIGEST_MSG = packet.Data.ToCArray();
+    for (argos::UInt32 b = 0; b < c_numDigestBuckets; ++b) {
+        if (loadUnaligned<argos::UInt32>(&DIGEST_MSG[1+sizeof(argos::UInt32)*b]) != m_digest[b]) {
+            m_digestMismatches |= (1u << b);
+        }
+    }
+    m_numMsgsRx += 1;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::_applyDigestMismatches() {
+    if (m_digestMismatches == 0) {
+        return;
+    }
+    // The entries that our neighbour lacks are sent ; the ones that we
+    // lack will be sent by our neighbour, which sees the same mismatch.
+    for (argos::UInt32 idx : m_ring) {
+        if (_isActive(idx) &&
+            (m_digestMismatches & (1u << _digestBucketOf(_robotAt(idx))))) {
+            _pushPending(idx);
+        }
+    }
+    m_digestMismatches = 0;
 }
 
 // ==============================
@@ -309,6 +932,32 @@ swlexp::Swarmlist::Entry::Entry(RobotId robot,
     resetTimer();
 }
 
+/****************************************/
+/****************************************/
+
+swlexp::Swarmlist::Entry::Entry(RobotId robot,
+                                argos::UInt8 swarmMask,
+                                Lamport32 lamport,
+                                argos::UInt32 timeToInactive)
+    : m_robot(robot)
+    , m_swarmMask(swarmMask)
+    , m_lamport(lamport)
+    , m_timeToInactive(timeToInactive)
+{ }
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::Entry::setTicksToInactive(argos::UInt32 ticksToInactive) {
+    // The timers are computed from update stamps modulo 2^24.
+    if (ticksToInactive > c_STAMP_MASK && ticksToInactive != (argos::UInt32)-1) {
+        throw std::domain_error("Entries cannot stay active for " +
+                                std::to_string(ticksToInactive) + " ticks ; at most " +
+                                std::to_string(c_STAMP_MASK) + " are supported.");
+    }
+    c_ticksToInactive = ticksToInactive;
+}
+
 // ==============================
 // =     SWARM_MSG_CALLBACK     =
 // ==============================
@@ -316,33 +965,44 @@ swlexp::Swarmlist::Entry::Entry(RobotId robot,
 void swlexp::Swarmlist::SwarmMsgCallback::operator()(
     const argos::CCI_RangeAndBearingSensor::SPacket& packet)
 {
-    const argos::UInt8* SWARM_MSG = packet.Data.ToCArray();
-    for (argos::UInt8 j = 0; j < c_numEntriesPerSwarmMsg; ++j) {
-        RobotId robot = *(const RobotId*)&SWARM_MSG[1+c_SWARM_ENTRY_SIZE*j+c_ROBOT_ID_POS];
-        // We have the most updated info about ourself ;
-        // don't update our info.
-        if (robot != m_swarmlist->m_id) {
-            argos::UInt8 swarmMask  = SWARM_MSG[1+c_SWARM_ENTRY_SIZE*j+c_SWARM_MASK_POS];
-            Lamport32 lamport = *(Lamport32*)&SWARM_MSG[1+c_SWARM_ENTRY_SIZE*j+c_LAMPORT_POS];
-            m_swarmlist->_update(robot, swarmMask, lamport);
-        }
+    m_swarmlist->_decodeSwarmMsg(packet);
+    m_swarmlist->_applyReceived();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::SwarmMsgCallback::operator()(
+    const Messenger::TPackets& packets)
+{
+    for (const argos::CCI_RangeAndBearingSensor::SPacket* packet : packets) {
+        m_swarmlist->_decodeSwarmMsg(*packet);
     }
-    m_swarmlist->m_numMsgsRx += 1;
+    m_swarmlist->_applyReceived();
 }
 
 /****************************************/
 /****************************************/
 
 // ==============================
-// =      GLOBAL FUNCTIONS      =
+// =    DIGEST_MSG_CALLBACK     =
 // ==============================
 
-void swlexp::writeInPacket(argos::CByteArray& packet,
-                           const swlexp::Swarmlist::Entry& entry,
-                           argos::UInt16 idx) {
-    argos::UInt8* data = packet.ToCArray();
-    const argos::UInt16 ENTRY_POS = 1 + Swarmlist::c_SWARM_ENTRY_SIZE * idx;
-    *(RobotId*)     &data[ENTRY_POS+Swarmlist::c_ROBOT_ID_POS]   = entry.getRobotId();
-    *(argos::UInt8*)&data[ENTRY_POS+Swarmlist::c_SWARM_MASK_POS] = entry.getSwarmMask();
-    *(Lamport32*)   &data[ENTRY_POS+Swarmlist::c_LAMPORT_POS]    = entry.getLamport();
+void swlexp::Swarmlist::DigestMsgCallback::operator()(
+    const argos::CCI_RangeAndBearingSensor::SPacket& packet)
+{
+    m_swarmlist->_decodeDigestMsg(packet);
+    m_swarmlist->_applyDigestMismatches();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Swarmlist::DigestMsgCallback::operator()(
+    const Messenger::TPackets& packets)
+{
+    for (const argos::CCI_RangeAndBearingSensor::SPacket* packet : packets) {
+        m_swarmlist->_decodeDigestMsg(*packet);
+    }
+    m_swarmlist->_applyDigestMismatches();
 }
@@ -6,12 +6,16 @@
 #ifndef SWARMLIST_H
 #define SWARMLIST_H
 
-#include <stdexcept> // std::domain_error
-#include <unordered_map>
+#include <algorithm> // std::max
+#include <random>    // std::default_random_engine
+#include <stdexcept> // std::out_of_range, std::domain_error
 #include <string>
 
 #include "include.h"
+#include "IdIndex.h"
 #include "Messenger.h"
+#include "ShardedCounter.h"
+#include "SwarmCodec.h"
 
 namespace swlexp {
 
@@ -23,12 +27,7 @@ namespace swlexp {
     protected:
 
         friend class SwarmMsgCallback;
-
-    public:
-        class Entry;
-        friend void writeInPacket(argos::CByteArray& packet,
-                                  const Swarmlist::Entry& entry,
-                                  argos::UInt16 idx);
+        friend class DigestMsgCallback;
 
     // ==============================
     // =       NESTED SYMBOLS       =
@@ -36,6 +35,14 @@ namespace swlexp {
 
     public:
 
+        /**
+         * Policy used to choose the entries to send in a swarm message.
+         */
+        enum SchedulingPolicy {
+            SCHEDULING_ROUND_ROBIN, ///< Every active entry is sent in turn.
+            SCHEDULING_FRESHNESS    ///< Recently updated entries are sent first, then the round robin resumes.
+        };
+
         /**
          * Entry of the Swarmlist.
          */
@@ -45,6 +52,9 @@ namespace swlexp {
 
             Entry(RobotId robot, argos::UInt8 swarmMask, Lamport32 lamport);
 
+            Entry(RobotId robot, argos::UInt8 swarmMask, Lamport32 lamport,
+                  argos::UInt32 timeToInactive);
+
             inline
             RobotId getRobotId() const { return m_robot; }
             inline
@@ -85,12 +95,23 @@ namespace swlexp {
             void incrementLamport() { ++m_lamport; }
 
         public:
+            /**
+             * Determines after how many ticks without any update we consider
+             * the entry to be inactive.
+             */
+            inline static
+            argos::UInt32 getTicksToInactive() { return c_ticksToInactive; }
+
             /**
              * Sets after how many ticks without any update we consider the entry
              * to be inactive.
+             * @throw std::domain_error The number of ticks does not fit in the
+             * 24-bit update stamps of the entries, and is not (UInt32)-1.
+             * @param[in] ticksToInactive The number of ticks, or (UInt32)-1
+             * for entries that never become inactive.
              */
-            inline static
-            void setTicksToInactive(argos::UInt32 ticksToInactive) { c_ticksToInactive = ticksToInactive; }
+            static
+            void setTicksToInactive(argos::UInt32 ticksToInactive);
 
         private:
             RobotId m_robot;                ///< Robot ID this entry is for.
@@ -105,7 +126,7 @@ namespace swlexp {
         /**
          * Callback class to handle swarm messages.
          */
-        class SwarmMsgCallback : public Messenger::Callback {
+        class SwarmMsgCallback final : public Messenger::Callback {
         public:
             SwarmMsgCallback(Swarmlist* swarmlist) : m_swarmlist(swarmlist) { }
             
@@ -115,6 +136,36 @@ namespace swlexp {
             virtual
             void operator()(const argos::CCI_RangeAndBearingSensor::SPacket& packet);
 
+            /**
+             * Deals with all the swarm messages received during a timestep.
+             * @see Swarmlist::ingest()
+             */
+            virtual
+            void operator()(const Messenger::TPackets& packets);
+
+        private:
+            Swarmlist* m_swarmlist;
+        };
+
+        /**
+         * Callback class to handle digest messages.
+         */
+        class DigestMsgCallback final : public Messenger::Callback {
+        public:
+            DigestMsgCallback(Swarmlist* swarmlist) : m_swarmlist(swarmlist) { }
+
+            /**
+             * Deals with an incoming digest message.
+             */
+            virtual
+            void operator()(const argos::CCI_RangeAndBearingSensor::SPacket& packet);
+
+            /**
+             * Deals with all the digest messages received during a timestep.
+             */
+            virtual
+            void operator()(const Messenger::TPackets& packets);
+
         private:
             Swarmlist* m_swarmlist;
         };
@@ -133,9 +184,15 @@ namespace swlexp {
 
         /**
          * Initializes the swarmlist.
+         * @throw std::domain_error The ID does not fit in the wire format,
+         * or the settings are not valid ; see reset().
          * @param[in] id The ID of the swarmlist's owner.
+         * @param[in] denseIdBound When the robot IDs are known to be dense,
+         * i.e., mostly in [0,denseIdBound), entries are indexed directly by
+         * their robot ID instead of being hashed. IDs outside of that range
+         * are still supported. Use 0 when the IDs are sparse.
          */
-        void init(RobotId id);
+        void init(RobotId id, RobotId denseIdBound = 0);
 
         /**
          * Function that should be called exactly once every timestep.
@@ -144,6 +201,8 @@ namespace swlexp {
 
         /**
          * Resets the swarmlist.
+         * @throw std::domain_error The packets are too small for digest
+         * messages.
          */
         void reset();
 
@@ -153,19 +212,41 @@ namespace swlexp {
          * the next entry to send.
          * @details This is used when we want to see how long it
          * would take for a new robot's data to be propagated
-         * through an existing swarm.
-         * @param[in] existingRobots A vector of all existing robots.
+         * through an existing swarm. The entries are cloned from the
+         * template built by prepareConsensus() ; all swarmlists send them
+         * in the same cyclic order, each from a random offset.
+         * @throw std::logic_error The template was not prepared for the
+         * dense ID bound of this swarmlist.
          */
-        void forceConsensus(const std::vector<RobotId>& existingRobots);
+        void forceConsensus();
 
         void setSwarmMask(argos::UInt8 swarmMask);
 
+        /**
+         * @brief Deals with all the packets received during a timestep at
+         * once.
+         * @details The swarm messages are decoded and deduplicated into a
+         * single entry per robot, with the effect of applying them in
+         * order. Then, a single update is applied per distinct robot. Digest messages are compared with
+         * our own digest. Other packets are ignored.
+         * @note Multiplexed packets are not unpacked here ; they must first
+         * go through the messenger.
+         * @param[in] readings The packets received during the timestep.
+         */
+        void ingest(const argos::CCI_RangeAndBearingSensor::TReadings& readings);
+
+        /**
+         * Determines the bound below which robot IDs are directly indexed.
+         */
+        inline
+        RobotId getDenseIdBound() const { return m_denseIdBound; }
+
         /**
          * Determines the total number of entries, be they active or inactive.
          * @return The total number of entries.
          */
         inline
-        argos::UInt32 getSize() const { return m_data.size(); }
+        argos::UInt32 getSize() const { return m_numEntries; }
 
         /**
          * Determines the total number of active entries.
@@ -175,21 +256,42 @@ namespace swlexp {
         argos::UInt32 getNumActive() const { return m_numActive; }
 
         /**
-         * Gets the number of swarm messages sent by the swarmlist
-         * since the beginning of the experiment.
+         * Gets the number of messages, be they swarm or digest messages,
+         * sent by the swarmlist since the beginning of the experiment.
          */
         inline
         argos::UInt64 getNumMsgsTx() const { return m_numMsgsTx; }
 
         /**
-         * Gets the number of swarm messages received by the swarmlist
-         * since the beginning of the experiment.
+         * Gets the number of messages, be they swarm or digest messages,
+         * received by the swarmlist since the beginning of the experiment.
          * @return The number of messages received by the footbots of this
          * controller since the beginning of the experiment.
          */
         inline
         argos::UInt64 getNumMsgsRx() const { return m_numMsgsRx; }
 
+        /**
+         * Gets the number of entries received in swarm messages since
+         * the beginning of the experiment.
+         */
+        inline
+        argos::UInt64 getNumEntriesRx() const { return m_numEntriesRx; }
+
+        /**
+         * Gets the number of received entries that created or updated an
+         * entry of the swarmlist.
+         */
+        inline
+        argos::UInt64 getNumUsefulEntriesRx() const { return m_numUsefulEntriesRx; }
+
+        /**
+         * Gets the number of received entries about a robot whose entry
+         * was already received during the same timestep.
+         */
+        inline
+        argos::UInt64 getNumDuplicateEntriesRx() const { return m_numDuplicateEntriesRx; }
+
         /**
          * Gets the highest value of the Ticks To Inactive of entries of
          * this robot before its update.
@@ -204,6 +306,11 @@ namespace swlexp {
         inline
         argos::Real getAverageTti() const { return (argos::Real)m_ttiSum / m_numUpdates; }
 
+        /**
+         * Determines the number of bytes of memory held by the swarmlist.
+         */
+        size_t getMemoryUsage() const;
+
         /**
          * Composes a string consisting of a set of
          * "(ID,lamport since update, time to inactive)"
@@ -222,14 +329,66 @@ namespace swlexp {
          * Gets an entry of the swarmlist given its robot ID.
          * @throw std::out_of_range The ID is not found.
          * @param[in] robot The robot ID whose data to fetch.
-         * @return The entry of the swarmlist corresponding to the passed ID.
+         * @return A copy of the entry of the swarmlist corresponding to
+         * the passed ID.
+         */
+        Entry _get(RobotId robot) const;
+
+        /**
+         * Determines the robot ID of the entry at some index.
+         */
+        inline
+        RobotId _robotAt(argos::UInt32 idx) const
+        { return idx < m_denseIdBound ? idx : m_ids[idx - m_denseIdBound]; }
+
+        /**
+         * Gets a copy of the entry at some index of the swarmlist.
+         * @param[in] idx The index of the entry.
+         * @return A copy of the entry.
+         */
+        inline
+        Entry _at(argos::UInt32 idx) const
+        { return Entry(_robotAt(idx), m_entries[idx].swarmMask, m_entries[idx].lamport, _getTimeToInactive(idx)); }
+
+        /**
+         * Determines whether the entry at some index is active.
+         * @see Entry::isActive()
          */
-        const Entry& _get(RobotId robot) const;
+        inline
+        bool _isActive(argos::UInt32 idx) const
+        { return (m_flags[idx] & FLAG_ACTIVE) != 0; }
 
         /**
-         * Adds/Modifies an entry of the swarmlist.
+         * Finds the index of the entry of a robot.
+         * @return The index of the entry, or IdIndex::NOT_FOUND if the
+         * robot has no entry.
          */
-        void _set(const Entry& entry);
+        inline
+        argos::UInt32 _find(RobotId robot) const {
+            const argos::UInt32 IDX =
+                (robot < m_denseIdBound) ? robot : m_idToIndex.find(robot);
+            return (IDX != IdIndex::NOT_FOUND && (m_flags[IDX] & FLAG_EXISTS)) ?
+                IDX : IdIndex::NOT_FOUND;
+        }
+
+        /**
+         * Determines the number of ticks until the entry at some index
+         * becomes inactive. This is 0 for inactive entries. The timer of
+         * our own entry wraps around, since our entry is always active.
+         */
+        inline
+        argos::UInt32 _getTimeToInactive(argos::UInt32 idx) const {
+            return _isActive(idx) ?
+                Entry::getTicksToInactive() - (((argos::UInt32)m_step - m_entries[idx].stamp) & c_STAMP_MASK) :
+                0;
+        }
+
+        /**
+         * Records that an entry was just updated, so that it becomes
+         * inactive once it has not been updated for long enough.
+         * @param[in] idx The index of the entry.
+         */
+        void _scheduleExpiry(argos::UInt32 idx);
 
 
         /**
@@ -242,7 +401,116 @@ namespace swlexp {
         void _update(RobotId robot, argos::UInt8 swarmMask, Lamport32 lamport);
 
         /**
-         * Removes 1 from all timers, and deals with old entries.
+         * Overwrites an existing entry that is older than the given data,
+         * and resets the entry's timer.
+         * @param[in] idx The index of the entry.
+         * @see _update()
+         */
+        void _overwrite(argos::UInt32 idx,
+                        RobotId robot,
+                        argos::UInt8 swarmMask,
+                        Lamport32 lamport);
+
+        /**
+         * Decodes the entries of a swarm message into the set of entries
+         * received during the current timestep. When a robot is already
+         * in that set, see _mergeDuplicate().
+         * @param[in] packet The swarm message.
+         */
+        void _decodeSwarmMsg(const argos::CCI_RangeAndBearingSensor::SPacket& packet);
+
+        /**
+         * Decodes the entries of a swarm message, at the width of the
+         * wire format. It is instantiated once per wire format, so that
+         * the entries are decoded and compared without indirect calls.
+         * @param[in] swarmMsg The swarm message, starting with its type.
+         * @param[in] numEntries The number of entries in the message.
+         * @see _decodeSwarmMsg()
+         */
+        template <class IdType, class LamportType>
+        void _decodeSwarmEntries(const argos::UInt8* swarmMsg, argos::UInt16 numEntries);
+
+        /**
+         * Merges an entry with the one received earlier for the same robot
+         * during the current timestep, so that applying the merged entry
+         * has the same effect as applying both in order. Keeping the
+         * newest one would not: the circular Lamport clock model is not
+         * transitive, and inactive entries take any different clock.
+         * @param[in] rxIdx The index of the earlier received entry.
+         * @param[in] swarmMask The swarm mask of the new entry.
+         * @param[in] lamport The Lamport clock of the new entry.
+         */
+        template <class LamportType>
+        void _mergeDuplicate(argos::UInt32 rxIdx, argos::UInt8 swarmMask, Lamport32 lamport);
+
+        /**
+         * Updates the swarmlist with the set of received entries, i.e.,
+         * once per distinct robot, then empties the set. The received
+         * Lamport clocks are compared to the stored ones in batches of
+         * LAMPORT_BATCH_SIZE.
+         */
+        void _applyReceived();
+
+        /**
+         * Compares a digest message with our digest. The entries of the
+         * buckets that differ will be sent.
+         * @param[in] packet The digest message.
+         */
+        void _decodeDigestMsg(const argos::CCI_RangeAndBearingSensor::SPacket& packet);
+
+        /**
+         * Marks for sending every active entry whose bucket differed
+         * from a received digest, then forgets the differing buckets.
+         */
+        void _applyDigestMismatches();
+
+        /**
+         * Computes the number of buckets of the digests from the packet
+         * size and the wire format.
+         * @throw std::domain_error The packets are too small for digest
+         * messages.
+         */
+        static
+        void _updateNumDigestBuckets();
+
+        /**
+         * Determines the digest bucket of a robot.
+         */
+        inline static
+        argos::UInt32 _digestBucketOf(RobotId robot) { return robot % c_numDigestBuckets; }
+
+        /**
+         * Adds or removes the contribution of an entry to its digest
+         * bucket. Applying this twice cancels it out.
+         * @param[in] idx The index of the entry.
+         */
+        void _toggleInDigest(argos::UInt32 idx);
+
+        /**
+         * Increments our own Lamport clock, so that others are aware
+         * that we still exist.
+         * @param[in] idx The index of our own entry.
+         */
+        void _incrementOwnLamport(argos::UInt32 idx);
+
+        /**
+         * Adds an entry to the entries that must be sent, if it is not
+         * already in them.
+         * @param[in] idx The index of the entry.
+         */
+        void _pushPending(argos::UInt32 idx);
+
+        /**
+         * Writes a digest message.
+         * @param[out] digestMsg The message to write to ; its type is already set.
+         */
+        void _makeDigestMessage(argos::UInt8* digestMsg);
+
+        /**
+         * Advances the swarmlist's step, and deals with the entries that
+         * expire at that step.
+         * Every entry lives for the same number of ticks after its update,
+         * so the updates expire in the order they were recorded.
          */
         void _tick();
 
@@ -252,16 +520,63 @@ namespace swlexp {
         void _next();
 
         /**
-         * Returns a copy of the next entry we will send.
-         * @return A copy of the next entry we will send.
+         * Adds an entry to the ring of entries to send, if it is not
+         * already in it.
+         * @param[in] idx The index of the entry.
+         */
+        void _addToRing(argos::UInt32 idx);
+
+        /**
+         * Removes the entry at the cursor from the ring of entries to
+         * send. The last entry of the ring takes its place.
+         */
+        void _removeNextFromRing();
+
+        /**
+         * Adds an entry to the back of the hot queue, if it is not
+         * already in it. When the queue is full, its oldest entry is
+         * dropped ; it is still sent by the round robin.
+         * @param[in] idx The index of the entry.
+         */
+        void _pushHot(argos::UInt32 idx);
+
+        /**
+         * Removes the entry at the front of the hot queue.
+         * @return The index of the entry.
+         */
+        argos::UInt32 _popHot();
+
+        /**
+         * Determines the next entry we will send.
+         * @return The index of the next entry we will send.
+         */
+        argos::UInt32 _getNext();
+
+        /**
+         * Encodes an entry into the swarm message being built.
+         * @param[out] swarmMsg The swarm message, starting with its type.
+         * @param[in] idx The index of the entry.
+         * @param[in] slot The position of the entry inside the message.
          */
-        Entry _getNext();
+        template <class IdType, class LamportType>
+        void _encodeInMessage(argos::UInt8* swarmMsg, argos::UInt32 idx, argos::UInt16 slot);
 
         /**
-         * Creates a swarm message.
-         * @return The created swarm message.
+         * Writes a swarm message.
+         * @param[out] swarmMsg The message to write to ; its type is already set.
+         * @param[in] numEntries The number of entries in the message.
          */
-        argos::CByteArray _makeNextMessage();
+        inline
+        void _makeNextMessage(argos::UInt8* swarmMsg, argos::UInt16 numEntries)
+        { (this->*c_fillSwarmMessage)(swarmMsg, numEntries); }
+
+        /**
+         * Writes a swarm message, at the width of the wire format.
+         * @see _makeNextMessage()
+         * @see _decodeSwarmEntries()
+         */
+        template <class IdType, class LamportType>
+        void _fillSwarmMessage(argos::UInt8* swarmMsg, argos::UInt16 numEntries);
 
         /**
          * Sends a set of swarm messages.
@@ -276,11 +591,28 @@ namespace swlexp {
 
         /**
          * Determines the total number of swarmlist entries in the entire swarm.
+         * @warning The controllers must not be running, e.g., call this
+         * from the loop functions.
          */
         inline static
-        argos::UInt64 getTotalNumActive() { return c_totalNumActive; }
+        argos::UInt64 getTotalNumActive() { return (argos::UInt64)c_totalNumActive.get(); }
 
 
+        /**
+         * @brief Builds the entries that forceConsensus() gives to every
+         * swarmlist.
+         * @details The robots are shuffled once, so that the order in
+         * which they are sent is random.
+         * @param[in] existingRobots A vector of all existing robots.
+         * @param[in] denseIdBound The dense ID bound of the swarmlists.
+         * @throw std::domain_error The packets are too small for digest
+         * messages.
+         * @see init()
+         */
+        static
+        void prepareConsensus(const std::vector<RobotId>& existingRobots,
+                              RobotId denseIdBound);
+
         /**
          * Determines whether existing entries should become inactive after a while.
          */
@@ -293,24 +625,229 @@ namespace swlexp {
         inline static
         void setEntriesShouldBecomeInactive(bool shouldBecomeInactive) { c_entriesShouldBecomeInactive = shouldBecomeInactive; }
 
+        /**
+         * Gets the wire format of the entries inside swarm messages.
+         */
+        inline static
+        const SwarmCodec& getWireFormat() { return *c_codec; }
+
+        /**
+         * @brief Sets the wire format of the entries inside swarm messages.
+         * @details Narrower robot IDs and Lamport clocks fit more entries
+         * in each swarm message. Lamport clocks are compared with the
+         * circular model at their encoded width. This must be called before
+         * the swarmlists are initialized.
+         * @throw std::domain_error The sizes are not 1, 2 or 4 bytes.
+         * @param[in] robotIdSize The size, in bytes, of an encoded robot ID.
+         * @param[in] lamportSize The size, in bytes, of an encoded Lamport clock.
+         */
+        static
+        void setWireFormat(argos::UInt8 robotIdSize, argos::UInt8 lamportSize);
+
+        /**
+         * Determines the number of entries sent per swarm message.
+         */
+        inline static
+        argos::UInt16 getNumEntriesPerSwarmMsg() { return c_numEntriesPerSwarmMsg; }
+
+        /**
+         * Gets the policy used to choose the entries to send.
+         */
+        inline static
+        SchedulingPolicy getSchedulingPolicy() { return c_schedulingPolicy; }
+
+        /**
+         * Sets the policy used to choose the entries to send.
+         */
+        inline static
+        void setSchedulingPolicy(SchedulingPolicy policy) { c_schedulingPolicy = policy; }
+
+        /**
+         * Gets the number of steps between two digest messages. 0 means
+         * that digests are disabled.
+         */
+        inline static
+        argos::UInt32 getDigestPeriod() { return c_digestPeriod; }
+
+        /**
+         * @brief Sets the number of steps between two digest messages.
+         * @details When this is not 0, the swarmlist runs in anti-entropy
+         * mode. Every 'digestPeriod' steps, it broadcasts a digest of its
+         * active entries instead of a swarm message. Between digests, it
+         * only sends swarm messages when there are entries to send, i.e.,
+         * entries it just updated and entries whose bucket differs from a
+         * neighbour's digest. Otherwise, it stays silent.
+         * When entries become inactive, our own entry is still refreshed
+         * often enough for our neighbours to keep it active, whatever the
+         * period.
+         * @param[in] digestPeriod The number of steps between two digests,
+         * or 0 to always send swarm messages.
+         */
+        inline static
+        void setDigestPeriod(argos::UInt32 digestPeriod) { c_digestPeriod = digestPeriod; }
+
+        /**
+         * Gets the maximum number of entries waiting in the hot queue
+         * of the freshness scheduling policy.
+         */
+        inline static
+        argos::UInt32 getHotQueueSize() { return c_hotQueueSize; }
+
+        /**
+         * Sets the maximum number of entries waiting in the hot queue
+         * of the freshness scheduling policy.
+         */
+        inline static
+        void setHotQueueSize(argos::UInt32 hotQueueSize) { c_hotQueueSize = hotQueueSize; }
+
+    private:
+
+        /**
+         * Selects the instances of the entry loops for a robot ID type.
+         * @param[in] lamportSize The size, in bytes, of an encoded Lamport clock.
+         * @see setWireFormat()
+         */
+        template <class IdType>
+        static
+        void _selectEntryLoops(argos::UInt8 lamportSize);
+
+        /**
+         * Determines whether a Lamport clock is newer than another one,
+         * at the width of the wire format.
+         */
+        inline static
+        bool _isNewer(Lamport32 lamport, Lamport32 other)
+        { return isNewerLamport(lamport, other, c_lamportMask); }
+
+        /**
+         * Gets the number of steps between two refreshes of our own entry
+         * in anti-entropy mode : one tick less than the entries last, so
+         * that our neighbours keep it active, and at least one step.
+         */
+        inline static
+        argos::UInt32 _getOwnRefreshPeriod()
+        { return std::max<argos::UInt32>(Entry::getTicksToInactive() - 1, 1); }
+
     // ==============================
     // =         ATTRIBUTES         =
     // ==============================
 
     private:
 
+        typedef void (Swarmlist::*TDecodeSwarmEntries)(const argos::UInt8*, argos::UInt16); ///< Instance of _decodeSwarmEntries().
+        typedef void (Swarmlist::*TFillSwarmMessage)(argos::UInt8*, argos::UInt16);        ///< Instance of _fillSwarmMessage().
+
+        /**
+         * Entry as stored in the swarmlist. Its robot ID is implicit.
+         */
+        struct PackedEntry {
+            argos::UInt32 lamport;        ///< Lamport clock.
+            argos::UInt32 swarmMask : 8;  ///< Data that we wish to share.
+            argos::UInt32 stamp     : 24; ///< Step of the last update, modulo 2^24.
+        };
+        static_assert(sizeof(PackedEntry) == 8, "A swarmlist entry should fit in 8 bytes.");
+
+        /**
+         * State bits of an entry.
+         */
+        enum EntryFlag : argos::UInt8 {
+            FLAG_EXISTS  = 1 << 0, ///< There is an entry at that index.
+            FLAG_ACTIVE  = 1 << 1, ///< The entry is active.
+            FLAG_IN_RING = 1 << 2, ///< The entry is in m_ring.
+            FLAG_IN_HOT  = 1 << 3, ///< The entry is in m_hot.
+            FLAG_PENDING = 1 << 4  ///< The entry is in m_pending.
+        };
+
+        /**
+         * How a received entry compares with the stored one.
+         */
+        enum RxState : argos::UInt8 {
+            RX_UNRESOLVED = 0, ///< Not compared yet ; it is applied if it is newer than the stored entry.
+            RX_CHANGED,        ///< Its duplicates were applied in order, and changed the stored entry.
+            RX_UNCHANGED       ///< Its duplicates were applied in order, and left the stored entry as is.
+        };
+
+        /**
+         * Entries of a swarmlist in a consensus state, without an owner.
+         * @see prepareConsensus()
+         */
+        struct ConsensusTemplate {
+            bool isPrepared;                   ///< Whether the template was built.
+            RobotId denseIdBound;              ///< Dense ID bound of the template.
+            std::vector<PackedEntry>  entries; ///< Index => Entry.
+            std::vector<argos::UInt8> flags;   ///< Index => EntryFlag bits of the entry.
+            std::vector<RobotId>      ids;     ///< Index - denseIdBound => Robot ID of the entry.
+            IdIndex idToIndex;                 ///< Robot ID => Index of the entry, for IDs outside of the dense bound.
+            std::vector<argos::UInt32> ring;   ///< Position => Index of an entry to send.
+            std::vector<argos::UInt32> digest; ///< Bucket => XOR of the hashes of its entries.
+        };
+
+        /**
+         * Update of an entry, waiting to expire.
+         */
+        struct ExpiryRecord {
+            argos::UInt32 idx;  ///< Index of the entry.
+            argos::UInt32 step; ///< Step of the update.
+        };
+
         RobotId m_id;                     ///< ID of the robot whose swarmlist this is.
-        std::vector<Entry> m_data;        ///< Index => Entry in O(1)
-        std::unordered_map<RobotId, argos::UInt32> m_idToIndex; ///< Robot ID => Index of m_data in O(1)
+        argos::UInt32 m_ownIdx;           ///< Index of our own entry.
+        RobotId m_denseIdBound;           ///< IDs below this bound are directly indexed.
+        // The entry of a robot whose ID is below m_denseIdBound is at the
+        // index equal to its ID. The other entries come after them, and
+        // are found through m_idToIndex.
+        std::vector<PackedEntry>  m_entries; ///< Index => Entry.
+        std::vector<argos::UInt8> m_flags;   ///< Index => EntryFlag bits of the entry.
+        std::vector<RobotId>      m_ids;     ///< Index - m_denseIdBound => Robot ID of the entry.
+        IdIndex m_idToIndex;              ///< Robot ID => Index of the entry in O(1), for IDs outside of the dense bound.
+        argos::UInt32 m_numEntries;       ///< Number of entries, be they active or inactive.
+
+        std::vector<ExpiryRecord> m_expiries; ///< Updates, in the order they expire. Our own entry never expires and is never in it.
+        argos::UInt32 m_expiryFront;          ///< Position, inside m_expiries, of the next update to expire.
+        argos::UInt64 m_step;                 ///< Number of ticks since the swarmlist was reset.
 
         argos::UInt32 m_numActive;        ///< Number of active entries.
-        argos::UInt32 m_next;             ///< The index of the next entry to send via a swarm chunk.
+        // Ring of the entries to send. Every active entry is in it ; inactive
+        // entries are removed from it lazily, when the cursor reaches them.
+        std::vector<argos::UInt32> m_ring; ///< Position => Index of an entry to send.
+        argos::UInt32 m_next;             ///< The position, inside m_ring, of the next entry to send via a swarm chunk.
+        // Hot queue of the freshness scheduling policy: a circular buffer
+        // of the entries updated since they were last sent.
+        std::vector<argos::UInt32> m_hot;   ///< Position => Index of an updated entry.
+        argos::UInt32 m_hotFront;           ///< Position, inside m_hot, of the oldest entry.
+        argos::UInt32 m_numHot;             ///< Number of entries in m_hot.
+
+        // Anti-entropy mode. The active entries are spread in buckets by
+        // robot ID ; the digest of a bucket is the XOR of the hashes of
+        // the (ID,Lamport clock) pairs of its entries, so it is updated
+        // in O(1) whenever an entry changes.
+        std::vector<argos::UInt32> m_digest;  ///< Bucket => XOR of the hashes of its active entries.
+        argos::UInt32 m_digestMismatches;     ///< Bit 'b' is set if bucket 'b' differed from a received digest.
+        std::vector<argos::UInt32> m_pending; ///< Indexes of the entries that must be sent, in order.
+        argos::UInt32 m_pendingFront;         ///< Position, inside m_pending, of the next entry to send.
+        argos::UInt32 m_stepsToDigest;        ///< Number of steps until we send our next digest.
+        argos::UInt32 m_stepsToRefresh;       ///< Number of steps until we refresh our own entry ; 0 if it never expires.
+
+        // Entries received during the current timestep, one per distinct
+        // robot. Their memory is kept from one timestep to the next.
+        std::vector<RobotId>      m_rxIds;      ///< Received robot IDs.
+        std::vector<argos::UInt8> m_rxMasks;    ///< Received swarm masks.
+        std::vector<Lamport32>    m_rxLamports; ///< Received Lamport clocks.
+        std::vector<argos::UInt8> m_rxStates;   ///< RxState of the received entries.
+        IdIndex m_rxIdToIndex;            ///< Robot ID => Index of the received entry.
+        std::vector<argos::UInt32> m_rxStoredIdx;      ///< Batch of received entries => Index of the stored entry.
+        std::vector<Lamport32>     m_rxStoredLamports; ///< Batch of received entries => Stored Lamport clock.
 
         argos::UInt64 m_numMsgsTx;        ///< Number of swarm messages transmitted since the beginning of the experiment.
         argos::UInt64 m_numMsgsRx;        ///< Number of swarm messages received since the beginning of the experiment.
+        argos::UInt64 m_numEntriesRx;          ///< Number of entries received since the beginning of the experiment.
+        argos::UInt64 m_numUsefulEntriesRx;    ///< Number of received entries that were applied.
+        argos::UInt64 m_numDuplicateEntriesRx; ///< Number of received entries about a robot already received in the same timestep.
 
         Messenger* m_msn;                 ///< Messenger object.
+        std::default_random_engine m_rng; ///< Random number generator of this swarmlist, seeded by init().
         SwarmMsgCallback m_swMsgCb;       ///< Callback object.
+        DigestMsgCallback m_digestMsgCb;  ///< Callback object for digests.
 
         argos::UInt32 m_highestTti;       ///< Highest Ticks To Inactive reached by an entry before its update during the experiment.
         argos::UInt64 m_ttiSum;
@@ -323,20 +860,23 @@ namespace swlexp {
     private:
 
         static bool c_entriesShouldBecomeInactive; ///< Whether existing entrie should become inactive after a while.
-        static argos::UInt64 c_totalNumActive;     ///< The sum, over all robots, of the number of active entries.
+        static ShardedCounter c_totalNumActive;    ///< The sum, over all robots, of the number of active entries.
 
         static argos::UInt16 c_numEntriesPerSwarmMsg;    ///< The number of data entries we transmit about other robots per packet.
-        static const argos::UInt16 c_SWARM_ENTRY_SIZE;   ///< Size of a single swarmlist entry in a message.
-        static const argos::UInt8 c_ROBOT_ID_POS;        ///< Offset, inside a swarmlist entry, of the robot's ID.
-        static const argos::UInt8 c_SWARM_MASK_POS;      ///< Offset, inside a swarmlist entry, of the swarm mask.
-        static const argos::UInt8 c_LAMPORT_POS;         ///< Offset, inside a swarmlist entry, of the lamport clock.
+        static const SwarmCodec* c_codec;                ///< Wire format of the entries inside swarm messages.
+        static argos::UInt32 c_lamportMask;              ///< Mask of the bits of the encoded Lamport clocks.
+        static TDecodeSwarmEntries c_decodeSwarmEntries; ///< Decoding loop of the wire format.
+        static TFillSwarmMessage c_fillSwarmMessage;     ///< Encoding loop of the wire format.
+        static SchedulingPolicy c_schedulingPolicy;      ///< Policy used to choose the entries to send.
+        static argos::UInt32 c_hotQueueSize;             ///< Capacity of the hot queue.
+        static argos::UInt32 c_digestPeriod;             ///< Number of steps between two digests ; 0 if disabled.
+        static argos::UInt32 c_numDigestBuckets;         ///< The number of buckets in a digest message.
+        static ConsensusTemplate c_consensus;            ///< Entries given by forceConsensus().
+        static const argos::UInt32 c_STAMP_MASK;         ///< Mask of the update stamps of the entries.
+        static const argos::UInt32 c_NO_ENTRY;           ///< Index meaning 'no entry' inside the hot queue.
 
     };
 
-    void writeInPacket(argos::CByteArray& packet,
-                       const Swarmlist::Entry& entry,
-                       argos::UInt16 idx);
-
 }
 
 #endif // !SWARMLIST_H
\ No newline at end of file
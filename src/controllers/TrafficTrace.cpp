@@ -0,0 +1,240 @@
+#include <argos3/core/utility/math/rng.h> // argos::CRandom
+#include <cstring>   // std::memcpy
+#include <stdexcept> // std::runtime_error
+#include <utility>   // std::move
+
+#include "TrafficTrace.h"
+#include "Swarmlist.h"
+
+namespace swlexp {
+    TrafficTrace TrafficTrace::c_inst;
+}
+
+static const argos::UInt32 VERSION = 2;
+
+/**
+ * Writes a value in a binary stream.
+ */
+template <class T>
+static void writeBinary(std::ostream& o, T value) {
+    o.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * Reads a value from a binary stream.
+ * @throw std::runtime_error The stream ended.
+ */
+template <class T>
+static T readBinary(std::istream& i) {
+    T value;
+    if (!i.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("Truncated traffic trace.");
+    }
+    return value;
+}
+
+/**
+ * Appends a value to a buffer.
+ */
+template <class T>
+static void appendBinary(std::vector<argos::UInt8>& data, T value) {
+    const size_t POS = data.size();
+    data.resize(POS + sizeof(T));
+    std::memcpy(&data[POS], &value, sizeof(T));
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::TrafficTrace::RobotTrace::RobotTrace(RobotId robot, argos::UInt32 firstStep)
+    : m_robot(robot)
+    , m_firstStep(firstStep)
+    , m_numSteps(0)
+{ }
+
+/****************************************/
+/****************************************/
+
+void swlexp::TrafficTrace::RobotTrace::record(const argos::CCI_RangeAndBearingSensor::TReadings& readings) {
+    appendBinary<argos::UInt16>(m_data, readings.size());
+    for (const argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
+        const argos::UInt8* DATA = packet.Data.ToCArray();
+        argos::UInt16 numStored = packet.Data.Size();
+        while (numStored > 0 && DATA[numStored - 1] == 0) {
+            --numStored;
+        }
+        appendBinary<argos::UInt16>(m_data, packet.Data.Size());
+        appendBinary<argos::UInt16>(m_data, numStored);
+        m_data.insert(m_data.end(), DATA, DATA + numStored);
+    }
+    ++m_numSteps;
+}
+
+/****************************************/
+/****************************************/
+
+size_t swlexp::TrafficTrace::RobotTrace::readStep(size_t pos, argos::CCI_RangeAndBearingSensor::TReadings& readings) const {
+    if (pos + sizeof(argos::UInt16) > m_data.size()) {
+        throw std::runtime_error("Truncated traffic trace.");
+    }
+    argos::UInt16 numPackets;
+    std::memcpy(&numPackets, &m_data[pos], sizeof(argos::UInt16));
+    pos += sizeof(argos::UInt16);
+    readings.resize(numPackets);
+    for (argos::CCI_RangeAndBearingSensor::SPacket& packet : readings) {
+        if (pos + 2 * sizeof(argos::UInt16) > m_data.size()) {
+            throw std::runtime_error("Truncated traffic trace.");
+        }
+        argos::UInt16 size;
+        argos::UInt16 numStored;
+        std::memcpy(&size, &m_data[pos], sizeof(argos::UInt16));
+        std::memcpy(&numStored, &m_data[pos + sizeof(argos::UInt16)], sizeof(argos::UInt16));
+        pos += 2 * sizeof(argos::UInt16);
+        if (numStored > size) {
+            throw std::runtime_error("Corrupt traffic trace.");
+        }
+        if (pos + numStored > m_data.size()) {
+            throw std::runtime_error("Truncated traffic trace.");
+        }
+        packet.Data.Resize(size);
+        packet.Data.Zero();
+        std::memcpy(packet.Data.ToCArray(), m_data.data() + pos, numStored);
+        pos += numStored;
+    }
+    return pos;
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::TrafficTrace::TrafficTrace()
+    : m_isEnabled(false)
+    , m_step(0)
+{
+    m_settings = Settings();
+    m_settings.consensusStep = NO_CONSENSUS;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TrafficTrace::init(const std::string& protocol, RobotId denseIdBound) {
+    m_isEnabled = true;
+    m_step = 0;
+    m_robots.clear();
+    m_settings = Settings();
+    m_settings.packetSize                  = getPacketSize();
+    m_settings.robotIdSize                 = Swarmlist::getWireFormat().getRobotIdSize();
+    m_settings.lamportSize                 = Swarmlist::getWireFormat().getLamportSize();
+    m_settings.schedulingPolicy            = Swarmlist::getSchedulingPolicy();
+    m_settings.entriesShouldBecomeInactive = Swarmlist::getEntriesShouldBecomeInactive();
+    m_settings.ticksToInactive             = Swarmlist::Entry::getTicksToInactive();
+    m_settings.hotQueueSize                = Swarmlist::getHotQueueSize();
+    m_settings.digestPeriod                = Swarmlist::getDigestPeriod();
+    m_settings.denseIdBound                = denseIdBound;
+    m_settings.randomSeed                  = argos::CRandom::GetCategory("argos").GetSeed();
+    m_settings.protocol                    = protocol;
+    m_settings.consensusStep               = NO_CONSENSUS;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TrafficTrace::recordConsensus(const std::vector<RobotId>& robots) {
+    m_settings.consensusStep   = m_step;
+    m_settings.consensusRobots = robots;
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::TrafficTrace::RobotTrace* swlexp::TrafficTrace::addRobot(RobotId robot) {
+    // The robot's first control step comes after the current step.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_robots.emplace_back(new RobotTrace(robot, m_step + 1));
+    return m_robots.back().get();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TrafficTrace::write(std::ostream& o) const {
+    o.write("SWTR", 4);
+    writeBinary<argos::UInt32>(o, VERSION);
+    writeBinary<argos::UInt16>(o, m_settings.packetSize);
+    writeBinary<argos::UInt8> (o, m_settings.robotIdSize);
+    writeBinary<argos::UInt8> (o, m_settings.lamportSize);
+    writeBinary<argos::UInt8> (o, m_settings.schedulingPolicy);
+    writeBinary<argos::UInt8> (o, m_settings.entriesShouldBecomeInactive);
+    writeBinary<argos::UInt32>(o, m_settings.ticksToInactive);
+    writeBinary<argos::UInt32>(o, m_settings.hotQueueSize);
+    writeBinary<argos::UInt32>(o, m_settings.digestPeriod);
+    writeBinary<argos::UInt32>(o, m_settings.denseIdBound);
+    writeBinary<argos::UInt32>(o, m_settings.randomSeed);
+    writeBinary<argos::UInt8> (o, m_settings.protocol.size());
+    o.write(m_settings.protocol.data(), m_settings.protocol.size());
+    writeBinary<argos::UInt32>(o, m_settings.consensusStep);
+    writeBinary<argos::UInt32>(o, m_settings.consensusRobots.size());
+    for (RobotId robot : m_settings.consensusRobots) {
+        writeBinary<argos::UInt32>(o, robot);
+    }
+    writeBinary<argos::UInt32>(o, m_robots.size());
+
+    for (const std::unique_ptr<RobotTrace>& robot : m_robots) {
+        writeBinary<argos::UInt32>(o, robot->m_robot);
+        writeBinary<argos::UInt32>(o, robot->m_firstStep);
+        writeBinary<argos::UInt32>(o, robot->m_numSteps);
+        writeBinary<argos::UInt64>(o, robot->m_data.size());
+        o.write(reinterpret_cast<const char*>(robot->m_data.data()), robot->m_data.size());
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TrafficTrace::read(std::istream& i) {
+    char magic[4];
+    if (!i.read(magic, 4) || std::memcmp(magic, "SWTR", 4) != 0) {
+        throw std::runtime_error("Not a traffic trace.");
+    }
+    if (readBinary<argos::UInt32>(i) != VERSION) {
+        throw std::runtime_error("Unsupported traffic trace version.");
+    }
+    m_settings.packetSize                  = readBinary<argos::UInt16>(i);
+    m_settings.robotIdSize                 = readBinary<argos::UInt8> (i);
+    m_settings.lamportSize                 = readBinary<argos::UInt8> (i);
+    m_settings.schedulingPolicy            = readBinary<argos::UInt8> (i);
+    m_settings.entriesShouldBecomeInactive = readBinary<argos::UInt8> (i);
+    m_settings.ticksToInactive             = readBinary<argos::UInt32>(i);
+    m_settings.hotQueueSize                = readBinary<argos::UInt32>(i);
+    m_settings.digestPeriod                = readBinary<argos::UInt32>(i);
+    m_settings.denseIdBound                = readBinary<argos::UInt32>(i);
+    m_settings.randomSeed                  = readBinary<argos::UInt32>(i);
+    m_settings.protocol.resize(readBinary<argos::UInt8>(i));
+    if (!i.read(&m_settings.protocol[0], m_settings.protocol.size())) {
+        throw std::runtime_error("Truncated traffic trace.");
+    }
+    m_settings.consensusStep               = readBinary<argos::UInt32>(i);
+    // Each robot is read before the next one is stored, so that a
+    // corrupted count cannot allocate more than the stream holds.
+    const argos::UInt32 NUM_CONSENSUS_ROBOTS = readBinary<argos::UInt32>(i);
+    m_settings.consensusRobots.clear();
+    for (argos::UInt32 r = 0; r < NUM_CONSENSUS_ROBOTS; ++r) {
+        m_settings.consensusRobots.push_back(readBinary<argos::UInt32>(i));
+    }
+
+    const argos::UInt32 NUM_ROBOTS = readBinary<argos::UInt32>(i);
+    m_robots.clear();
+    for (argos::UInt32 r = 0; r < NUM_ROBOTS; ++r) {
+        const RobotId ROBOT            = readBinary<argos::UInt32>(i);
+        const argos::UInt32 FIRST_STEP = readBinary<argos::UInt32>(i);
+        std::unique_ptr<RobotTrace> robot(new RobotTrace(ROBOT, FIRST_STEP));
+        robot->m_numSteps = readBinary<argos::UInt32>(i);
+        robot->m_data.resize(readBinary<argos::UInt64>(i));
+        if (!i.read(reinterpret_cast<char*>(robot->m_data.data()), robot->m_data.size())) {
+            throw std::runtime_error("Truncated traffic trace.");
+        }
+        m_robots.push_back(std::move(robot));
+    }
+    m_isEnabled = false;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file TrafficTrace.h
+ * @brief Definition of the TrafficTrace class.
+ */
+
+#ifndef TRAFFIC_TRACE_H
+#define TRAFFIC_TRACE_H
+
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Packets received by every robot at every step, so that the
+     * swarmlists can be replayed without the simulator.
+     * @details The messengers record what they receive ; each robot
+     * appends to its own RobotTrace, so no lock is taken while stepping.
+     * Only the data of the packets is kept ; the swarmlist does not use
+     * their range and bearing.
+     *
+     * Binary output, in host byte order:
+     * - Header: "SWTR", UInt32 version, then the settings of the run:
+     *   UInt16 packet size, UInt8 robot ID size, UInt8 Lamport clock
+     *   size, UInt8 scheduling policy, UInt8 whether entries become
+     *   inactive, UInt32 ticks to inactive, UInt32 hot queue size, UInt32
+     *   digest period, UInt32 dense ID bound, UInt32 random seed, UInt8
+     *   protocol length and the protocol's characters, UInt32 consensus
+     *   step, UInt32 number of robots 'C' at the consensus and their C
+     *   UInt32 IDs ; then UInt32 number of robot traces 'R'.
+     * - For each of the R robot traces: UInt32 robot ID, UInt32 first
+     *   step, UInt32 number of steps, UInt64 number of bytes, then the
+     *   steps.
+     * - Each step: UInt16 number of packets, then for each packet UInt16
+     *   size, UInt16 number of stored bytes, then the stored bytes ; the
+     *   trailing zeros of a packet are not stored.
+     */
+    class TrafficTrace {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Settings of the swarmlists and of the run during the recording.
+         */
+        struct Settings {
+            argos::UInt16 packetSize;
+            argos::UInt8  robotIdSize;
+            argos::UInt8  lamportSize;
+            argos::UInt8  schedulingPolicy;
+            argos::UInt8  entriesShouldBecomeInactive;
+            argos::UInt32 ticksToInactive;
+            argos::UInt32 hotQueueSize;
+            argos::UInt32 digestPeriod;
+            RobotId       denseIdBound;
+            argos::UInt32 randomSeed;             ///< Seed of the "argos" random category.
+            std::string   protocol;               ///< Protocol of the experiment.
+            argos::UInt32 consensusStep;          ///< Step after which the swarmlists were forced to consensus ; NO_CONSENSUS if they were not.
+            std::vector<RobotId> consensusRobots; ///< Robots present when the swarmlists were forced to consensus.
+        };
+
+        /**
+         * Consensus step of a recording where the swarmlists were not
+         * forced to consensus.
+         */
+        static const argos::UInt32 NO_CONSENSUS = (argos::UInt32)-1;
+
+        /**
+         * Packets received by a robot, one step after the other.
+         */
+        class RobotTrace {
+
+        public:
+
+            /**
+             * Class constructor.
+             * @param[in] robot The ID of the robot.
+             * @param[in] firstStep The step of the first recorded packets.
+             */
+            RobotTrace(RobotId robot, argos::UInt32 firstStep);
+
+            /**
+             * Appends the packets received during a step.
+             * @param[in] readings The packets.
+             */
+            void record(const argos::CCI_RangeAndBearingSensor::TReadings& readings);
+
+            /**
+             * Decodes the packets received during a step.
+             * @throw std::runtime_error The step runs past the end of the
+             * data, or a packet stores more bytes than its size.
+             * @param[in] pos The position of the step inside the data.
+             * @param[out] readings The packets. The vector and the packets
+             * are resized rather than reallocated, so that replaying a
+             * step does not allocate in steady state.
+             * @return The position of the next step.
+             */
+            size_t readStep(size_t pos, argos::CCI_RangeAndBearingSensor::TReadings& readings) const;
+
+            inline
+            RobotId getRobotId() const { return m_robot; }
+
+            inline
+            argos::UInt32 getFirstStep() const { return m_firstStep; }
+
+            inline
+            argos::UInt32 getNumSteps() const { return m_numSteps; }
+
+        private:
+
+            friend class TrafficTrace;
+
+            RobotId m_robot;                 ///< ID of the robot.
+            argos::UInt32 m_firstStep;       ///< Step of the first recorded packets.
+            argos::UInt32 m_numSteps;        ///< Number of recorded steps.
+            std::vector<argos::UInt8> m_data; ///< Recorded steps.
+
+        };
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        TrafficTrace();
+
+        /**
+         * Starts recording, with the current settings of the swarmlists
+         * and the seed of the "argos" random category.
+         * @param[in] protocol The protocol of the experiment.
+         * @param[in] denseIdBound The dense ID bound of the swarmlists.
+         */
+        void init(const std::string& protocol, RobotId denseIdBound);
+
+        /**
+         * Records that the swarmlists are forced to consensus after the
+         * current step, so that a replay forces them too.
+         * @param[in] robots The robots present, as given to
+         * Swarmlist::prepareConsensus().
+         */
+        void recordConsensus(const std::vector<RobotId>& robots);
+
+        /**
+         * Determines whether the packets are being recorded.
+         */
+        inline
+        bool isEnabled() const { return m_isEnabled; }
+
+        /**
+         * Sets the current step.
+         */
+        inline
+        void setStep(argos::UInt32 step) { m_step = step; }
+
+        /**
+         * Adds a robot, whose packets are recorded from the next step on.
+         * @param[in] robot The ID of the robot.
+         * @return The trace of the robot. It lives as long as the trace.
+         */
+        RobotTrace* addRobot(RobotId robot);
+
+        /**
+         * Gets the traces of the robots, in the order they were added.
+         */
+        inline
+        const std::vector<std::unique_ptr<RobotTrace>>& getRobots() const { return m_robots; }
+
+        /**
+         * Gets the settings of the swarmlists and of the run during the
+         * recording.
+         */
+        inline
+        const Settings& getSettings() const { return m_settings; }
+
+        /**
+         * Writes the trace.
+         * @param[out] o The binary stream to write to.
+         */
+        void write(std::ostream& o) const;
+
+        /**
+         * Reads a trace written by write().
+         * @throw std::runtime_error The stream does not hold a valid trace.
+         * @param[in] i The binary stream to read from.
+         */
+        void read(std::istream& i);
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Instance getter.
+         */
+        inline static
+        TrafficTrace& getInst() { return c_inst; }
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    private:
+
+        static TrafficTrace c_inst; ///< Instance.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        bool m_isEnabled;                                 ///< Whether the packets are being recorded.
+        argos::UInt32 m_step;                             ///< Current step.
+        Settings m_settings;                              ///< Settings of the swarmlists.
+        std::vector<std::unique_ptr<RobotTrace>> m_robots; ///< Traces of the robots.
+        std::mutex m_mutex;                               ///< Lock on m_robots.
+
+    };
+
+}
+
+#endif // !TRAFFIC_TRACE_H
@@ -7,6 +7,9 @@
 #define INCLUDE_H
 
 #include <argos3/core/utility/datatypes/datatypes.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace swlexp {
 
@@ -66,6 +69,85 @@ namespace swlexp {
     typedef Lamport<argos::UInt16> Lamport16;
     typedef Lamport<argos::UInt32> Lamport32;
 
+    /**
+     * @brief Determines whether a Lamport clock is newer than another one,
+     * using the same circular model as Lamport::isNewerThan().
+     * @details A clock is newer if it is 1 to LAMPORT_THRESHOLD ticks ahead
+     * of the other clock, modulo the width of the clocks.
+     * @param[in] lamport The Lamport clock that might be newer.
+     * @param[in] other The Lamport clock to compare to.
+     * @param[in] widthMask Mask of the bits of the clocks, e.g., 0xFF to
+     * compare 8-bit clocks stored in Lamport32.
+     * @return Whether 'lamport' is newer than 'other'.
+     */
+    inline
+    bool isNewerLamport(Lamport32 lamport, Lamport32 other, argos::UInt32 widthMask) {
+        // A difference of 0 wraps to the largest value.
+        return ((((argos::UInt32)lamport - (argos::UInt32)other) & widthMask) - 1) < LAMPORT_THRESHOLD;
+    }
+
+    /**
+     * Maximum number of Lamport clocks compared by newerLamportMask().
+     */
+    #define LAMPORT_BATCH_SIZE 64
+
+    /**
+     * @brief Determines which Lamport clocks of a batch are newer than
+     * others, using the same circular model as Lamport::isNewerThan().
+     * @details A clock is newer if it is 1 to LAMPORT_THRESHOLD ticks ahead
+     * of the other clock, modulo the width of the clocks ; the difference
+     * is computed with AVX2 or SSE2 when available, without branching.
+     * @param[in] lamports The Lamport clocks that might be newer.
+     * @param[in] others The Lamport clocks to compare to.
+     * @param[in] num The number of clocks, at most LAMPORT_BATCH_SIZE.
+     * @param[in] widthMask Mask of the bits of the clocks, e.g., 0xFF to
+     * compare 8-bit clocks stored in Lamport32.
+     * @return Bit 'i' is set if lamports[i] is newer than others[i].
+     */
+    inline
+    argos::UInt64 newerLamportMask(const Lamport32* lamports,
+                                   const Lamport32* others,
+                                   argos::UInt32 num,
+                                   argos::UInt32 widthMask) {
+        // Newer iff ((lamport - other) & widthMask) - 1 < LAMPORT_THRESHOLD,
+        // unsigned ; a difference of 0 wraps to the largest value.
+        argos::UInt64 mask = 0;
+        argos::UInt32 i = 0;
+#if defined(__AVX2__)
+        // There is no unsigned comparison ; flip the sign bits and compare
+        // as signed integers.
+        const __m256i WIDTH     = _mm256_set1_epi32(widthMask);
+        const __m256i ONE       = _mm256_set1_epi32(1);
+        const __m256i SIGN      = _mm256_set1_epi32(0x80000000);
+        const __m256i THRESHOLD = _mm256_set1_epi32(0x80000000 + LAMPORT_THRESHOLD);
+        for (; i + 8 <= num; i += 8) {
+            __m256i diff = _mm256_sub_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&lamports[i])),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&others[i])));
+            diff = _mm256_xor_si256(_mm256_sub_epi32(_mm256_and_si256(diff, WIDTH), ONE), SIGN);
+            const __m256i NEWER = _mm256_cmpgt_epi32(THRESHOLD, diff);
+            mask |= (argos::UInt64)_mm256_movemask_ps(_mm256_castsi256_ps(NEWER)) << i;
+        }
+#elif defined(__SSE2__)
+        const __m128i WIDTH     = _mm_set1_epi32(widthMask);
+        const __m128i ONE       = _mm_set1_epi32(1);
+        const __m128i SIGN      = _mm_set1_epi32(0x80000000);
+        const __m128i THRESHOLD = _mm_set1_epi32(0x80000000 + LAMPORT_THRESHOLD);
+        for (; i + 4 <= num; i += 4) {
+            __m128i diff = _mm_sub_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&lamports[i])),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&others[i])));
+            diff = _mm_xor_si128(_mm_sub_epi32(_mm_and_si128(diff, WIDTH), ONE), SIGN);
+            const __m128i NEWER = _mm_cmplt_epi32(diff, THRESHOLD);
+            mask |= (argos::UInt64)_mm_movemask_ps(_mm_castsi128_ps(NEWER)) << i;
+        }
+#endif
+        for (; i < num; ++i) {
+            mask |= (argos::UInt64)isNewerLamport(lamports[i], others[i], widthMask) << i;
+        }
+        return mask;
+    }
+
     // ==============================
     // =     UTILITY FUNCTIONS      =
     // ==============================
@@ -0,0 +1,552 @@
+#include <argos3/core/utility/math/rng.h> // argos::CRandom
+#include <algorithm> // std::max
+#include <cmath>     // std::floor
+#include <random>    // std::seed_seq, std::bernoulli_distribution
+#include <stdexcept> // std::invalid_argument, std::domain_error, std::runtime_error
+#include <string>
+#include <unordered_map>
+
+#include "HeadlessSim.h"
+#include "PropagationStats.h"
+#include "TrafficTrace.h"
+#include "loops/Topology.h"
+#include "loops/TopologyFile.h"
+
+namespace swlexp {
+    argos::UInt16 HeadlessSim::c_packetSize;
+    argos::Real   HeadlessSim::c_packetDropProb;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt16 swlexp::getPacketSize() {
+    return swlexp::HeadlessSim::getPacketSize();
+}
+
+/****************************************/
+/****************************************/
+
+argos::Real swlexp::getPacketDropProb() {
+    return swlexp::HeadlessSim::getPacketDropProb();
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::HeadlessSim::Robot::Robot(RobotId id)
+    : id(id)
+    , swarmlist(&messenger)
+{
+    // Like the swarmlist, derive the drops from the seed of the run and
+    // the robot's ID, so that they do not depend on how many numbers the
+    // placement drew. The extra value keeps them apart from the
+    // swarmlist's own numbers.
+    std::seed_seq seed = { argos::CRandom::GetCategory("argos").GetSeed(), id, 1u };
+    dropRng.seed(seed);
+    for (argos::CByteArray& outbox : outboxes) {
+        outbox.Resize(getPacketSize());
+        outbox.Zero();
+    }
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::HeadlessSim::HeadlessSim(const Config& config)
+    : m_config(config)
+    , m_time(0)
+    , m_isTopologyLoaded(false)
+    , m_pool(config.numThreads)
+{
+    c_packetSize     = config.packetSize;
+    c_packetDropProb = config.packetDropProb;
+
+    // Like ExpLoopFunc::Init().
+    try {
+        Swarmlist::setWireFormat(config.robotIdSize, config.lamportSize);
+    }
+    catch (const std::domain_error& e) {
+        throw std::invalid_argument(e.what());
+    }
+    if (config.numRobots > 0 &&
+        config.numRobots - 1 > Swarmlist::getWireFormat().getMaxRobotId()) {
+        throw std::invalid_argument(
+            "Robot IDs of " + std::to_string(config.numRobots) + " robots do not fit in " +
+            std::to_string(config.robotIdSize) + "-byte robot IDs.");
+    }
+    if (config.scheduler == "roundrobin") {
+        Swarmlist::setSchedulingPolicy(Swarmlist::SCHEDULING_ROUND_ROBIN);
+    }
+    else if (config.scheduler == "freshness") {
+        Swarmlist::setSchedulingPolicy(Swarmlist::SCHEDULING_FRESHNESS);
+    }
+    else {
+        throw std::invalid_argument("Unknown scheduler: \"" + config.scheduler + "\"");
+    }
+    Swarmlist::setHotQueueSize(config.hotQueueSize);
+    Swarmlist::setDigestPeriod(config.digestPeriod);
+
+    // Like the constructors of the experiment states.
+    if (config.protocol == "consensus") {
+        Swarmlist::setEntriesShouldBecomeInactive(true);
+        Swarmlist::Entry::setTicksToInactive((argos::UInt32)-1);
+    }
+    else if (config.protocol == "adding") {
+        Swarmlist::setEntriesShouldBecomeInactive(false);
+    }
+    else if (config.protocol == "removing") {
+        Swarmlist::setEntriesShouldBecomeInactive(true);
+    }
+    else {
+        throw std::invalid_argument("Unknown protocol: \"" + config.protocol + "\"");
+    }
+    // One robot is taken out of the swarm, so another must remain.
+    if (config.protocol != "consensus" && config.numRobots < 2) {
+        throw std::invalid_argument(
+            "The \"" + config.protocol + "\" protocol needs at least 2 robots.");
+    }
+
+    // The placement, the swarmlists and the packet drops take their random
+    // number generators from the simulator's category.
+    if (argos::CRandom::ExistsCategory("argos")) {
+        argos::CRandom::RemoveCategory("argos");
+    }
+    argos::CRandom::CreateCategory("argos", config.randomSeed);
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::HeadlessSim::~HeadlessSim() {
+
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::init() {
+    const argos::UInt32 NUM_ROBOTS = m_config.numRobots;
+
+    // Place the robots like last time, unless the file cannot be used.
+    m_isTopologyLoaded = false;
+    TopologyFile file;
+    if (m_config.topologyFile != "" &&
+        file.load(m_config.topologyFile, m_config.topology, NUM_ROBOTS, m_config.randomSeed)) {
+        m_positions = file.getPositions();
+        m_graph     = file.getGraph();
+        m_isTopologyLoaded = true;
+    }
+    else {
+        _placeRobots();
+    }
+
+    m_robots.clear();
+    m_robots.resize(NUM_ROBOTS);
+    for (RobotId id = 0; id < NUM_ROBOTS; ++id) {
+        _addRobot(id);
+    }
+
+    // Like ExpState::init().
+    if (m_config.protocol == "adding" && NUM_ROBOTS > 0) {
+        // Remove one robot, force consensus and add the robot back.
+        const RobotId FARTHEST = _findFarthestFromOrigin();
+        m_robots[FARTHEST].reset();
+        _forceConsensus();
+        _addRobot(FARTHEST);
+    }
+    else if (m_config.protocol == "removing" && NUM_ROBOTS > 0) {
+        // Force consensus, then remove one robot.
+        _forceConsensus();
+        m_robots[_findFarthestFromOrigin()].reset();
+    }
+    _splitInChunks();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_placeRobots() {
+    const argos::UInt32 NUM_ROBOTS = m_config.numRobots;
+    const argos::Real MIN_DISTANCE = 2.0 * Topology::getFootbotRadius();
+    const argos::Real MIN_DISTANCE_SQUARED = argos::Square(MIN_DISTANCE);
+
+    // Place the robots ; a robot fits where it does not overlap those
+    // already placed. The robots are bucketed in cells one diameter wide,
+    // so a robot can only overlap those of the 3x3 cells around it.
+    // The area of the topology is not known here, hence the hash map.
+    auto cellOf = [MIN_DISTANCE](argos::Real coord) {
+        return (argos::SInt32)std::floor(coord / MIN_DISTANCE);
+    };
+    auto cellKey = [](argos::SInt32 x, argos::SInt32 y) {
+        return ((argos::UInt64)(argos::UInt32)x << 32) | (argos::UInt32)y;
+    };
+    std::unordered_map<argos::UInt64, std::vector<argos::UInt32>> cells;
+    m_positions.assign(NUM_ROBOTS, argos::CVector2());
+    std::vector<argos::CRadians> orientations(NUM_ROBOTS);
+    Topology::place(m_config.topology, NUM_ROBOTS,
+        [&](argos::UInt32 robot,
+            const argos::CVector2& position,
+            const argos::CRadians& orientation) {
+            const argos::SInt32 CELL_X = cellOf(position.GetX());
+            const argos::SInt32 CELL_Y = cellOf(position.GetY());
+            for (argos::SInt32 x = CELL_X - 1; x <= CELL_X + 1; ++x) {
+                for (argos::SInt32 y = CELL_Y - 1; y <= CELL_Y + 1; ++y) {
+                    auto it = cells.find(cellKey(x, y));
+                    if (it == cells.end()) {
+                        continue;
+                    }
+                    for (argos::UInt32 i : it->second) {
+                        if ((m_positions[i] - position).SquareLength() < MIN_DISTANCE_SQUARED) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            cells[cellKey(CELL_X, CELL_Y)].push_back(robot);
+            m_positions[robot]  = position;
+            orientations[robot] = orientation;
+            return true;
+        });
+
+    if (m_config.topologyFile == "") {
+        m_graph.build(m_positions, Topology::getRabRange(m_config.topology));
+        return;
+    }
+    // Save the placement for the next runs.
+    TopologyFile file;
+    file.set(m_config.topology,
+             m_config.randomSeed,
+             Topology::getRabRange(m_config.topology),
+             m_positions,
+             orientations);
+    m_graph = file.getGraph();
+    file.save(m_config.topologyFile);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::step() {
+    ++m_time;
+    PropagationStats::getInst().setStep(m_time);
+    TrafficTrace::getInst().setStep(m_time);
+
+    const argos::UInt32 PARITY = m_time % 2;
+    m_pool.run(m_chunks, [this, PARITY](argos::UInt32 begin, argos::UInt32 end) {
+        for (argos::UInt32 i = begin; i < end; ++i) {
+            Robot* robot = m_robots[i].get();
+            if (robot != nullptr) {
+                _deliver(*robot, 1 - PARITY);
+                _controlStep(*robot, PARITY);
+            }
+        }
+    });
+    PropagationStats::getInst().merge();
+}
+
+/****************************************/
+/****************************************/
+
+bool swlexp::HeadlessSim::isFinished() const {
+    argos::UInt64 numPresent = 0;
+    for (const std::unique_ptr<Robot>& robot : m_robots) {
+        if (robot) {
+            ++numPresent;
+        }
+    }
+    return Swarmlist::getTotalNumActive() == numPresent * numPresent;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_addRobot(RobotId id) {
+    std::unique_ptr<Robot> robot(new Robot(id));
+    robot->messenger.init(&robot->transmitter, &robot->receiver);
+    if (TrafficTrace::getInst().isEnabled()) {
+        robot->messenger.setCapture(TrafficTrace::getInst().addRobot(id));
+    }
+    robot->swarmlist.init(id, m_config.numRobots);
+    robot->swarmlist.setSwarmMask(0x01);
+    m_robots[id] = std::move(robot);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_forceConsensus() {
+    std::vector<RobotId> existingRobots;
+    for (const std::unique_ptr<Robot>& robot : m_robots) {
+        if (robot) {
+            existingRobots.push_back(robot->id);
+        }
+    }
+    if (TrafficTrace::getInst().isEnabled()) {
+        TrafficTrace::getInst().recordConsensus(existingRobots);
+    }
+    Swarmlist::prepareConsensus(existingRobots, m_config.numRobots);
+    for (std::unique_ptr<Robot>& robot : m_robots) {
+        if (robot) {
+            robot->swarmlist.forceConsensus();
+            robot->messenger.resetCounters();
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::RobotId swlexp::HeadlessSim::_findFarthestFromOrigin() const {
+    argos::Real largestDistance = 0.0;
+    RobotId farthest = 0;
+    for (const std::unique_ptr<Robot>& robot : m_robots) {
+        if (robot) {
+            const argos::Real DISTANCE = m_positions[robot->id].Length();
+            if (DISTANCE > largestDistance) {
+                largestDistance = DISTANCE;
+                farthest = robot->id;
+            }
+        }
+    }
+    return farthest;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_splitInChunks() {
+    // More chunks than threads, so that the threads can balance them.
+    const argos::UInt32 CHUNKS_PER_THREAD = 16;
+    const std::vector<argos::UInt32>& OFFSETS = m_graph.getOffsets();
+
+    // A robot costs its control step, plus one per packet received.
+    std::vector<argos::UInt64> costs(m_robots.size(), 0);
+    argos::UInt64 totalCost = 0;
+    for (RobotId id = 0; id < m_robots.size(); ++id) {
+        if (m_robots[id]) {
+            costs[id] = 1 + OFFSETS[id + 1] - OFFSETS[id];
+            totalCost += costs[id];
+        }
+    }
+
+    m_chunks.assign(1, 0);
+    if (m_pool.getNumThreads() > 1) {
+        const argos::UInt64 NUM_CHUNKS = (argos::UInt64)m_pool.getNumThreads() * CHUNKS_PER_THREAD;
+        const argos::UInt64 CHUNK_COST = std::max(totalCost / NUM_CHUNKS, (argos::UInt64)1);
+        argos::UInt64 cost = 0;
+        for (RobotId id = 0; id + 1 < m_robots.size(); ++id) {
+            cost += costs[id];
+            // Close the chunk before a robot that would overfill it.
+            if (cost >= CHUNK_COST || cost + costs[id + 1] > 2 * CHUNK_COST) {
+                m_chunks.push_back(id + 1);
+                cost = 0;
+            }
+        }
+    }
+    m_chunks.push_back(m_robots.size());
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_deliver(Robot& robot, argos::UInt32 parity) {
+    // The packets are copied into the readings already allocated.
+    argos::CCI_RangeAndBearingSensor::TReadings& readings = robot.receiver.getReadings();
+    size_t numReadings = 0;
+    const std::vector<argos::UInt32>& OFFSETS    = m_graph.getOffsets();
+    const std::vector<argos::UInt32>& NEIGHBOURS = m_graph.getNeighbours();
+    for (argos::UInt32 e = OFFSETS[robot.id]; e < OFFSETS[robot.id + 1]; ++e) {
+        const Robot* sender = m_robots[NEIGHBOURS[e]].get();
+        // Robots that have nothing to send are not worth a packet ; the
+        // messenger ignores empty packets anyway.
+        if (sender == nullptr || sender->outboxes[parity][0] == Messenger::MSG_TYPE_NOTHING) {
+            continue;
+        }
+        if (c_packetDropProb > 0 && std::bernoulli_distribution(c_packetDropProb)(robot.dropRng)) {
+            continue;
+        }
+        if (numReadings == readings.size()) {
+            readings.emplace_back();
+        }
+        readings[numReadings].Data = sender->outboxes[parity];
+        ++numReadings;
+    }
+    readings.resize(numReadings);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::_controlStep(Robot& robot, argos::UInt32 parity) {
+    robot.messenger.controlStep();
+    robot.swarmlist.controlStep();
+    robot.messenger.flushTx();
+    robot.outboxes[parity] = robot.transmitter.getData();
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::writeStatusLogHeader(std::ostream& o) {
+    static const std::string STATUS_LOG_HEADER = std::string() +
+        "ID"                       + c_CSV_DELIM +
+        "Time (ts)"                + c_CSV_DELIM +
+        "Num msgs tx"              + c_CSV_DELIM +
+        "Avg. tx bandwidth (B/ts)" + c_CSV_DELIM +
+        "Num msgs rx"              + c_CSV_DELIM +
+        "Avg. rx bandwidth (B/ts)" + c_CSV_DELIM +
+        "Swl size"                 + c_CSV_DELIM +
+        "Swl num active\n";
+    o << STATUS_LOG_HEADER;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::writeStatusLogs(std::ostream& o, bool sideEffect) {
+    for (std::unique_ptr<Robot>& robot : m_robots) {
+        if (!robot) {
+            continue;
+        }
+        const argos::UInt64 NUM_MSGS_TX = robot->swarmlist.getNumMsgsTx();
+        const argos::UInt64 NUM_MSGS_RX = robot->swarmlist.getNumMsgsRx();
+        const argos::UInt64 NUM_MSGS_TX_SINCE_LOG = NUM_MSGS_TX - robot->numMsgsTxAtLastLog;
+        const argos::UInt64 NUM_MSGS_RX_SINCE_LOG = NUM_MSGS_RX - robot->numMsgsRxAtLastLog;
+        argos::Real bwTx = 0;
+        argos::Real bwRx = 0;
+        if (m_time != robot->timeAtLastLog) {
+            bwTx = (argos::Real)(NUM_MSGS_TX_SINCE_LOG) / (m_time - robot->timeAtLastLog);
+            bwRx = (argos::Real)(NUM_MSGS_RX_SINCE_LOG) / (m_time - robot->timeAtLastLog);
+        }
+
+        o << "fb" << robot->id                   << c_CSV_DELIM <<
+             m_time                              << c_CSV_DELIM <<
+             NUM_MSGS_TX_SINCE_LOG               << c_CSV_DELIM <<
+             bwTx                                << c_CSV_DELIM <<
+             NUM_MSGS_RX_SINCE_LOG               << c_CSV_DELIM <<
+             bwRx                                << c_CSV_DELIM <<
+             robot->swarmlist.getSize()          << c_CSV_DELIM <<
+             robot->swarmlist.getNumActive()     << "\n";
+
+        if (sideEffect) {
+            robot->numMsgsTxAtLastLog = NUM_MSGS_TX;
+            robot->numMsgsRxAtLastLog = NUM_MSGS_RX;
+            robot->timeAtLastLog      = m_time;
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::writeTtiData(std::ostream& o) const {
+    argos::UInt64 totalTtiRequired = 0;
+    argos::UInt32 maxTtiRequired = 0;
+    argos::Real sumAvgTtis = 0.0;
+    argos::UInt32 numRobots = 0;
+    for (const std::unique_ptr<Robot>& robot : m_robots) {
+        if (!robot) {
+            continue;
+        }
+        const argos::UInt32 TTI_REQUIRED = robot->swarmlist.getHighestTti();
+        if (TTI_REQUIRED > maxTtiRequired) {
+            maxTtiRequired = TTI_REQUIRED;
+        }
+        totalTtiRequired += TTI_REQUIRED;
+        sumAvgTtis += robot->swarmlist.getAverageTti();
+        ++numRobots;
+        o << TTI_REQUIRED << c_CSV_DELIM;
+    }
+    o << '\n';
+    o << ((numRobots > 0) ? sumAvgTtis / numRobots : 0) << '\n';
+    o << ((numRobots > 0) ? (argos::Real)totalTtiRequired / numRobots : 0) << '\n';
+    o << maxTtiRequired << '\n';
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::HeadlessSim::writeResults(std::ostream& res, std::ostream& log) const {
+    argos::UInt32 numRobots = 0;
+    argos::UInt64 numMsgsTx = 0;
+    argos::UInt64 numMsgsRx = 0;
+    argos::UInt64 swarmlistMemory = 0;
+    argos::UInt64 numMsnAllocations = 0;
+    argos::UInt64 bytesTx[Messenger::MSG_TYPE_COUNT] = { 0 };
+    argos::UInt64 paddingBytesTx = 0;
+    argos::UInt64 multiplexedTx = 0;
+    argos::UInt64 entriesRx = 0;
+    argos::UInt64 usefulEntriesRx = 0;
+    argos::UInt64 duplicateEntriesRx = 0;
+    for (const std::unique_ptr<Robot>& robot : m_robots) {
+        if (!robot) {
+            continue;
+        }
+        ++numRobots;
+        numMsgsTx          += robot->swarmlist.getNumMsgsTx();
+        numMsgsRx          += robot->swarmlist.getNumMsgsRx();
+        swarmlistMemory    += robot->swarmlist.getMemoryUsage();
+        numMsnAllocations  += robot->messenger.getNumAllocations();
+        for (argos::UInt32 type = 0; type < Messenger::MSG_TYPE_COUNT; ++type) {
+            bytesTx[type]  += robot->messenger.getNumBytesTx((Messenger::MsgType)type);
+        }
+        paddingBytesTx     += robot->messenger.getNumPaddingBytesTx();
+        multiplexedTx      += robot->messenger.getNumMultiplexedTx();
+        entriesRx          += robot->swarmlist.getNumEntriesRx();
+        usefulEntriesRx    += robot->swarmlist.getNumUsefulEntriesRx();
+        duplicateEntriesRx += robot->swarmlist.getNumDuplicateEntriesRx();
+    }
+
+    // Like ExpLoopFunc::_finishExperiment(), but an empty swarm or a run
+    // that ended at once must not divide by 0.
+    const bool HAS_RUN = (m_time > 0 && numRobots > 0);
+    const argos::Real BW_TX = HAS_RUN ?
+        ((argos::Real)numMsgsTx / m_time / numRobots) * c_packetSize : 0;
+    const argos::Real BW_RX = HAS_RUN ?
+        ((argos::Real)numMsgsRx / m_time / numRobots) * c_packetSize : 0;
+    const argos::UInt64 AVG_SWARMLIST_MEMORY = (numRobots > 0) ?
+        swarmlistMemory / numRobots : 0;
+    const argos::UInt64 SWARM_BYTES_TX  = bytesTx[Messenger::MSG_TYPE_SWARM];
+    const argos::UInt64 DIGEST_BYTES_TX = bytesTx[Messenger::MSG_TYPE_DIGEST];
+    const argos::UInt64 MULTI_BYTES_TX  = bytesTx[Messenger::MSG_TYPE_MULTI];
+    const argos::UInt64 TOTAL_BYTES_TX =
+        SWARM_BYTES_TX + DIGEST_BYTES_TX + MULTI_BYTES_TX + paddingBytesTx;
+    const argos::Real PACKET_UTILIZATION = (TOTAL_BYTES_TX > 0) ?
+        (argos::Real)(SWARM_BYTES_TX + DIGEST_BYTES_TX) / TOTAL_BYTES_TX : 0;
+    const argos::UInt64 REDUNDANT_ENTRIES_RX =
+        entriesRx - usefulEntriesRx - duplicateEntriesRx;
+
+    res << c_CSV_DELIM << m_time <<
+           c_CSV_DELIM << numMsgsTx <<
+           c_CSV_DELIM << numMsgsRx <<
+           c_CSV_DELIM << BW_TX <<
+           c_CSV_DELIM << BW_RX <<
+           c_CSV_DELIM << SWARM_BYTES_TX <<
+           c_CSV_DELIM << DIGEST_BYTES_TX <<
+           c_CSV_DELIM << MULTI_BYTES_TX <<
+           c_CSV_DELIM << paddingBytesTx <<
+           c_CSV_DELIM << PACKET_UTILIZATION <<
+           c_CSV_DELIM << entriesRx <<
+           c_CSV_DELIM << usefulEntriesRx <<
+           c_CSV_DELIM << REDUNDANT_ENTRIES_RX <<
+           c_CSV_DELIM << duplicateEntriesRx;
+    log << "Consensus (ts): " << m_time << "\n"
+           "Msgs sent (total): " << numMsgsTx << "\n"
+           "Msgs received (total): " << numMsgsRx << "\n"
+           "Avg. sent bandwidth (B/(timestep*foot-bot)): " << BW_TX << "\n"
+           "Avg. received bandwidth (B/(timestep*foot-bot)): " << BW_RX << "\n"
+           "Avg. swarmlist memory (B/foot-bot): " << AVG_SWARMLIST_MEMORY << "\n"
+           "Messenger buffer allocations (total): " << numMsnAllocations << "\n"
+           "Swarm message bytes sent (total): " << SWARM_BYTES_TX << "\n"
+           "Digest message bytes sent (total): " << DIGEST_BYTES_TX << "\n"
+           "Multiplexing bytes sent (total): " << MULTI_BYTES_TX << "\n"
+           "Padding bytes sent (total): " << paddingBytesTx << "\n"
+           "Packets with several messages sent (total): " << multiplexedTx << "\n"
+           "Packet utilization: " << PACKET_UTILIZATION << "\n"
+           "Swarmlist entries received (total): " << entriesRx << "\n"
+           "Useful swarmlist entries received (total): " << usefulEntriesRx << "\n"
+           "Redundant swarmlist entries received (total): " << REDUNDANT_ENTRIES_RX << "\n"
+           "Duplicate swarmlist entries received (total): " << duplicateEntriesRx << "\n"
+           "\n";
+}
@@ -0,0 +1,300 @@
+/**
+ * @file HeadlessSim.h
+ * @brief Definition of the HeadlessSim class.
+ */
+
+#ifndef HEADLESS_SIM_H
+#define HEADLESS_SIM_H
+
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_actuator.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Messenger.h"
+#include "Swarmlist.h"
+#include "ThreadPool.h"
+#include "loops/NeighbourGraph.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Steps the swarmlists of static robots without the simulator.
+     * @details The robots are placed like in RobotPlacer, then only their
+     * neighbour graph is kept: a packet sent by a robot during a step is
+     * received by each of its neighbours during the next step, unless it
+     * is dropped. The robots run the same Messenger and Swarmlist as
+     * FootbotController, and the protocols start like in ExpState.
+     * Unlike with the range and bearing medium, the robots do not occlude
+     * each other.
+     */
+    class HeadlessSim {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Parameters of an experiment ; they have the names and defaults
+         * of the attributes of the loop functions.
+         */
+        struct Config {
+            std::string   protocol;
+            std::string   topology;
+            argos::UInt32 numRobots      = 0;
+            argos::Real   packetDropProb = 0;
+            argos::UInt16 packetSize     = 91;
+            argos::UInt32 robotIdSize    = sizeof(RobotId);
+            argos::UInt32 lamportSize    = sizeof(Lamport32);
+            std::string   scheduler      = "roundrobin";
+            argos::UInt32 hotQueueSize   = Swarmlist::getHotQueueSize();
+            argos::UInt32 digestPeriod   = 0;
+            argos::UInt32 randomSeed     = 0;
+            argos::UInt32 numThreads     = 0; ///< Threads that step the robots ; 0 steps them in the calling thread.
+            std::string   topologyFile;       ///< Placement loaded if the file exists, saved otherwise ; empty for none.
+        };
+
+    private:
+
+        /**
+         * Range and bearing actuator that keeps the packet to send.
+         * Its buffer has the size of the packets, as SetData() requires.
+         */
+        class Transmitter : public argos::CCI_RangeAndBearingActuator {
+        public:
+            Transmitter() { m_cData.Resize(getPacketSize()); }
+            inline
+            const argos::CByteArray& getData() const { return m_cData; }
+        };
+
+        /**
+         * Range and bearing sensor whose readings are set by the simulator.
+         */
+        class Receiver : public argos::CCI_RangeAndBearingSensor {
+        public:
+            inline
+            TReadings& getReadings() { return m_tReadings; }
+        };
+
+        /**
+         * Everything a robot needs to be stepped.
+         */
+        struct Robot {
+            explicit
+            Robot(RobotId id);
+            RobotId id;
+            Transmitter transmitter;
+            Receiver receiver;
+            Messenger messenger;
+            Swarmlist swarmlist;
+            argos::CByteArray outboxes[2];                ///< Step parity => Packet sent during the last step of that parity.
+            std::default_random_engine dropRng;           ///< Packet drops of the robot's receiver.
+            argos::UInt32 timeAtLastLog = (argos::UInt32)-1; ///< Time at the last status log.
+            argos::UInt64 numMsgsTxAtLastLog = 0;         ///< Number of sent messages at the last status log.
+            argos::UInt64 numMsgsRxAtLastLog = 0;         ///< Number of received messages at the last status log.
+        };
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        /**
+         * Class constructor.
+         * Sets the swarmlists up for the experiment.
+         * @throw std::invalid_argument A parameter is not valid.
+         * @param[in] config The parameters of the experiment.
+         */
+        explicit
+        HeadlessSim(const Config& config);
+
+        ~HeadlessSim();
+
+        /**
+         * Places the robots and starts the protocol, like ExpState::init().
+         * Throws an ARGoS exception if the robots cannot be placed.
+         * @throw std::runtime_error The topology file cannot be saved.
+         */
+        void init();
+
+        /**
+         * Delivers the packets sent during the last step to every robot,
+         * and performs its control step.
+         */
+        void step();
+
+        /**
+         * Determines whether every robot has an active entry for every
+         * robot, like FootbotController::isConsensusReached().
+         */
+        bool isFinished() const;
+
+        /**
+         * Gets the number of steps performed.
+         */
+        inline
+        argos::UInt32 getTime() const { return m_time; }
+
+        /**
+         * Gets the neighbour graph of the robots.
+         */
+        inline
+        const NeighbourGraph& getGraph() const { return m_graph; }
+
+        /**
+         * Determines whether the robots were placed like in the topology
+         * file, rather than saved to it.
+         */
+        inline
+        bool isTopologyLoaded() const { return m_isTopologyLoaded; }
+
+        /**
+         * Gets the number of threads that step the robots.
+         */
+        inline
+        argos::UInt32 getNumThreads() const { return m_pool.getNumThreads(); }
+
+        /**
+         * Gets the parameters of the experiment.
+         */
+        inline
+        const Config& getConfig() const { return m_config; }
+
+        /**
+         * Writes the status log of every robot, in the format of
+         * FootbotController::getCsvStatusLog().
+         * @param[in,out] o The stream to write the status logs into.
+         * @param[in] sideEffect Whether the bandwidths of the next status
+         * logs are computed from now on.
+         */
+        void writeStatusLogs(std::ostream& o, bool sideEffect);
+
+        /**
+         * Writes the Ticks To Inactive data, like
+         * FootbotController::writeTtiData().
+         * @param[in,out] o The stream to write the data to.
+         */
+        void writeTtiData(std::ostream& o) const;
+
+        /**
+         * Writes the results of a finished experiment, like
+         * ExpLoopFunc::_finishExperiment().
+         * @param[in,out] res The result file ; the parameters of the
+         * experiment must already be on its last line.
+         * @param[in,out] log The log file.
+         */
+        void writeResults(std::ostream& res, std::ostream& log) const;
+
+    private:
+
+        HeadlessSim(HeadlessSim&) = delete;
+        HeadlessSim& operator=(const HeadlessSim&) = delete;
+
+        /**
+         * Places the robots like RobotPlacer, and saves the placement if
+         * a topology file is set.
+         */
+        void _placeRobots();
+
+        /**
+         * Creates a robot, like FootbotController::Init().
+         */
+        void _addRobot(RobotId id);
+
+        /**
+         * Gives every robot an entry for every present robot, like
+         * FootbotController::forceConsensus().
+         */
+        void _forceConsensus();
+
+        /**
+         * Determines which present robot is the farthest from the origin.
+         */
+        RobotId _findFarthestFromOrigin() const;
+
+        /**
+         * Splits the robots in chunks for the threads. The cost of a step
+         * grows with the number of packets a robot receives, so each chunk
+         * gets about the same total degree: a hub of a scale-free graph
+         * gets a chunk of its own, and the threads steal the other chunks
+         * while it is stepped.
+         */
+        void _splitInChunks();
+
+        /**
+         * Puts the packets that the neighbours of a robot sent during the
+         * last step in the readings of the robot.
+         * @param[in,out] robot The robot.
+         * @param[in] parity The parity of the last step.
+         */
+        void _deliver(Robot& robot, argos::UInt32 parity);
+
+        /**
+         * Performs the control step of a robot, like
+         * FootbotController::ControlStep(), and fills its outbox.
+         * @param[in,out] robot The robot.
+         * @param[in] parity The parity of the current step.
+         */
+        void _controlStep(Robot& robot, argos::UInt32 parity);
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Writes the first line of the status logs.
+         * @param[in,out] o The stream to write the header line into.
+         */
+        static
+        void writeStatusLogHeader(std::ostream& o);
+
+        /**
+         * Gets the size of the packets.
+         */
+        inline static
+        argos::UInt16 getPacketSize() { return c_packetSize; }
+
+        /**
+         * Gets the packet drop probability.
+         */
+        inline static
+        argos::Real getPacketDropProb() { return c_packetDropProb; }
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    private:
+
+        static const char c_CSV_DELIM = ','; ///< Delimiter between two CSV values.
+        static argos::UInt16 c_packetSize;    ///< Size of the packets.
+        static argos::Real c_packetDropProb;  ///< Probability of occurrence of a packet drop.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        Config m_config;                               ///< Parameters of the experiment.
+        argos::UInt32 m_time;                          ///< Number of steps performed.
+        std::vector<argos::CVector2> m_positions;      ///< Robot ID => Position on the ground.
+        NeighbourGraph m_graph;                        ///< Robots within communication range of each other.
+        bool m_isTopologyLoaded;                       ///< Whether the robots were placed like in the topology file.
+        std::vector<std::unique_ptr<Robot>> m_robots;  ///< Robot ID => Robot ; null if absent.
+        ThreadPool m_pool;                             ///< Threads that step the robots.
+        std::vector<argos::UInt32> m_chunks;           ///< Bounds of the chunks of robots stepped by a thread at once.
+
+    };
+
+}
+
+#endif // !HEADLESS_SIM_H
@@ -0,0 +1,183 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+/****************************************/
+/****************************************/
+
+swlexp::ThreadPool::ThreadPool(argos::UInt32 numThreads)
+    : m_deques(new ChunkDeque[std::max(numThreads, (argos::UInt32)1)])
+    , m_task(nullptr)
+    , m_chunks(nullptr)
+    , m_loop(0)
+    , m_numBusy(0)
+    , m_isStopping(false)
+{
+    for (argos::UInt32 thread = 1; thread < numThreads; ++thread) {
+        m_workers.emplace_back(&ThreadPool::_work, this, thread);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_loopReady.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::ThreadPool::run(const std::vector<argos::UInt32>& chunks, const TTask& task) {
+    if (chunks.size() < 2) {
+        return;
+    }
+    if (m_workers.empty()) {
+        task(chunks.front(), chunks.back());
+        return;
+    }
+
+    // Give each thread a contiguous range of the chunks.
+    const argos::UInt64 NUM_CHUNKS = chunks.size() - 1;
+    for (argos::UInt32 thread = 0; thread < getNumThreads(); ++thread) {
+        m_deques[thread].reset((argos::UInt32)(NUM_CHUNKS * thread / getNumThreads()),
+                               (argos::UInt32)(NUM_CHUNKS * (thread + 1) / getNumThreads()));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task    = &task;
+        m_chunks  = &chunks;
+        m_numBusy = m_workers.size();
+        m_error   = nullptr;
+        ++m_loop;
+    }
+    m_loopReady.notify_all();
+
+    std::exception_ptr error;
+    try {
+        _runChunks(0);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_loopDone.wait(lock, [this] { return m_numBusy == 0; });
+    if (error == nullptr) {
+        error = m_error;
+    }
+    m_task   = nullptr;
+    m_chunks = nullptr;
+    lock.unlock();
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::ThreadPool::_work(argos::UInt32 thread) {
+    argos::UInt64 lastLoop = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_loopReady.wait(lock, [this, lastLoop] { return m_isStopping || m_loop != lastLoop; });
+            if (m_isStopping) {
+                return;
+            }
+            lastLoop = m_loop;
+        }
+
+        std::exception_ptr error;
+        try {
+            _runChunks(thread);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        bool isLast;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error != nullptr && m_error == nullptr) {
+                m_error = error;
+            }
+            isLast = (--m_numBusy == 0);
+        }
+        if (isLast) {
+            m_loopDone.notify_one();
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::ThreadPool::_runChunks(argos::UInt32 thread) {
+    const std::vector<argos::UInt32>& CHUNKS = *m_chunks;
+    argos::UInt32 chunk;
+    while (m_deques[thread].popFront(chunk)) {
+        (*m_task)(CHUNKS[chunk], CHUNKS[chunk + 1]);
+    }
+    // Nothing is added to the deques during a loop: once a deque is
+    // empty, it stays empty.
+    for (argos::UInt32 i = 1; i < getNumThreads(); ++i) {
+        ChunkDeque& victim = m_deques[(thread + i) % getNumThreads()];
+        while (victim.popBack(chunk)) {
+            (*m_task)(CHUNKS[chunk], CHUNKS[chunk + 1]);
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::ThreadPool::ChunkDeque::reset(argos::UInt32 front, argos::UInt32 back) {
+    bounds.store(((argos::UInt64)front << 32) | back, std::memory_order_relaxed);
+}
+
+/****************************************/
+/****************************************/
+
+bool swlexp::ThreadPool::ChunkDeque::popFront(argos::UInt32& chunk) {
+    argos::UInt64 current = bounds.load(std::memory_order_relaxed);
+    while (true) {
+        const argos::UInt32 FRONT = (argos::UInt32)(current >> 32);
+        const argos::UInt32 BACK  = (argos::UInt32)current;
+        if (FRONT >= BACK) {
+            return false;
+        }
+        if (bounds.compare_exchange_weak(current, current + ((argos::UInt64)1 << 32),
+                                         std::memory_order_relaxed)) {
+            chunk = FRONT;
+            return true;
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+bool swlexp::ThreadPool::ChunkDeque::popBack(argos::UInt32& chunk) {
+    argos::UInt64 current = bounds.load(std::memory_order_relaxed);
+    while (true) {
+        const argos::UInt32 FRONT = (argos::UInt32)(current >> 32);
+        const argos::UInt32 BACK  = (argos::UInt32)current;
+        if (FRONT >= BACK) {
+            return false;
+        }
+        if (bounds.compare_exchange_weak(current, current - 1,
+                                         std::memory_order_relaxed)) {
+            chunk = BACK - 1;
+            return true;
+        }
+    }
+}
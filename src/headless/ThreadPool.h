@@ -0,0 +1,156 @@
+/**
+ * @file ThreadPool.h
+ * @brief Definition of the ThreadPool class.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Threads that share the work of a loop, one loop at a time.
+     * @details The calling thread takes part in each loop, so a pool of
+     * one thread runs everything in the calling thread.
+     *
+     * The items of a loop are grouped in chunks. Each thread starts with
+     * a deque holding a contiguous range of the chunks, and runs them from
+     * the front. Once its deque is empty, it steals chunks from the back
+     * of the deques of the other threads, so that a thread whose chunks
+     * take longer does not hold the others up.
+     */
+    class ThreadPool {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Processes the items [begin,end) of a loop.
+         */
+        typedef std::function<void(argos::UInt32 begin, argos::UInt32 end)> TTask;
+
+    private:
+
+        /**
+         * Chunks left to a thread, [front,back), packed in a single word
+         * so that the owner and the thieves take them with a CAS.
+         * Chunks are only added before a loop starts. The deques are
+         * allocated on the heap, so they are padded rather than aligned
+         * to keep them on separate cache lines.
+         */
+        struct ChunkDeque {
+
+            /**
+             * Replaces the chunks of the deque ; not thread-safe.
+             */
+            void reset(argos::UInt32 front, argos::UInt32 back);
+
+            /**
+             * Takes the chunk at the front, for the owner.
+             * @param[out] chunk The chunk taken.
+             * @return Whether there was a chunk left.
+             */
+            bool popFront(argos::UInt32& chunk);
+
+            /**
+             * Takes the chunk at the back, for a thief.
+             * @param[out] chunk The chunk taken.
+             * @return Whether there was a chunk left.
+             */
+            bool popBack(argos::UInt32& chunk);
+
+            std::atomic<argos::UInt64> bounds; ///< Front in the upper half, back in the lower half.
+            char padding[64 - sizeof(std::atomic<argos::UInt64>)];
+        };
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        /**
+         * Class constructor.
+         * Starts the threads.
+         * @param[in] numThreads The number of threads, counting the
+         * calling thread ; 0 is the same as 1.
+         */
+        explicit
+        ThreadPool(argos::UInt32 numThreads);
+
+        /**
+         * Class destructor.
+         * Stops the threads.
+         */
+        ~ThreadPool();
+
+        /**
+         * Runs a loop on every thread, and waits until it is done.
+         * If a task throws, the exception is rethrown here once every
+         * thread is done.
+         * @param[in] chunks The bounds of the chunks: chunk 'c' is the
+         * items [chunks[c],chunks[c+1]). It must outlive the loop.
+         * @param[in] task Processes a range of the items.
+         */
+        void run(const std::vector<argos::UInt32>& chunks, const TTask& task);
+
+        /**
+         * Gets the number of threads, counting the calling thread.
+         */
+        inline
+        argos::UInt32 getNumThreads() const { return m_workers.size() + 1; }
+
+    private:
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Main function of a worker thread.
+         * @param[in] thread The index of the thread ; the calling thread
+         * is 0.
+         */
+        void _work(argos::UInt32 thread);
+
+        /**
+         * Runs the chunks of a thread, then those it can steal.
+         */
+        void _runChunks(argos::UInt32 thread);
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        std::vector<std::thread> m_workers;  ///< Threads other than the calling thread.
+        std::unique_ptr<ChunkDeque[]> m_deques; ///< Thread => Chunks of the current loop left to the thread.
+        std::mutex m_mutex;                  ///< Lock on the attributes below.
+        std::condition_variable m_loopReady; ///< Signals a new loop, or the end.
+        std::condition_variable m_loopDone;  ///< Signals that the workers are done.
+        const TTask* m_task;                 ///< Task of the current loop.
+        const std::vector<argos::UInt32>* m_chunks; ///< Bounds of the chunks of the current loop.
+        argos::UInt64 m_loop;                ///< Number of loops started.
+        argos::UInt32 m_numBusy;             ///< Number of workers still running the current loop.
+        std::exception_ptr m_error;          ///< First exception thrown during the current loop.
+        bool m_isStopping;                   ///< Whether the workers must stop.
+
+    };
+
+}
+
+#endif // !THREAD_POOL_H
@@ -0,0 +1,265 @@
+#include <cstdio>    // std::remove
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits> // std::is_floating_point, std::is_unsigned
+
+#include "HeadlessSim.h"
+#include "PropagationStats.h"
+#include "TrafficTrace.h"
+
+/**
+ * Command line options ; the names are those of the attributes in
+ * swarmlist_sim.argos.
+ */
+class Options {
+
+public:
+
+    /**
+     * Parses arguments of the form --name=value.
+     * @throw std::invalid_argument An argument is not of that form.
+     */
+    Options(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string ARG = argv[i];
+            const size_t EQUALS = ARG.find('=');
+            if (ARG.compare(0, 2, "--") != 0 || EQUALS == std::string::npos) {
+                throw std::invalid_argument("Invalid argument \"" + ARG + "\".");
+            }
+            m_values[ARG.substr(2, EQUALS - 2)] = ARG.substr(EQUALS + 1);
+        }
+    }
+
+    /**
+     * Gets the value of an option.
+     * @throw std::invalid_argument The option is required and missing.
+     */
+    std::string get(const std::string& name, const char* defaultValue = nullptr) const {
+        auto it = m_values.find(name);
+        if (it != m_values.end()) {
+            return it->second;
+        }
+        if (defaultValue == nullptr) {
+            throw std::invalid_argument("Missing argument --" + name + "=...");
+        }
+        return defaultValue;
+    }
+
+    /**
+     * Gets the value of a numeric option.
+     * @throw std::invalid_argument The option is required and missing, or
+     * its value is not a number of type T.
+     */
+    template <class T>
+    T getNumber(const std::string& name, T defaultValue) const {
+        return (m_values.count(name) > 0) ? getNumber<T>(name) : defaultValue;
+    }
+
+    template <class T>
+    T getNumber(const std::string& name) const {
+        const std::string VALUE = get(name);
+        try {
+            return parse<T>(VALUE, std::is_floating_point<T>());
+        }
+        catch (const std::logic_error&) {
+            // std::invalid_argument and std::out_of_range.
+            throw std::invalid_argument("Invalid value for --" + name + ": \"" + VALUE + "\".");
+        }
+    }
+
+private:
+
+    /**
+     * Parses a floating-point number.
+     * @throw std::logic_error The value is not one.
+     */
+    template <class T>
+    static T parse(const std::string& value, std::true_type) {
+        size_t end;
+        const T RESULT = (T)std::stod(value, &end);
+        if (end != value.size()) {
+            throw std::invalid_argument(value);
+        }
+        return RESULT;
+    }
+
+    /**
+     * Parses an unsigned integer. std::stoul() accepts a minus sign and
+     * wraps the value around, so negative values are rejected first.
+     * @throw std::logic_error The value is not one, or does not fit in T.
+     */
+    template <class T>
+    static T parse(const std::string& value, std::false_type) {
+        static_assert(std::is_unsigned<T>::value, "Options are unsigned.");
+        if (value.find('-') != std::string::npos) {
+            throw std::out_of_range(value);
+        }
+        size_t end;
+        const unsigned long RESULT = std::stoul(value, &end);
+        if (end != value.size() || RESULT > std::numeric_limits<T>::max()) {
+            throw std::out_of_range(value);
+        }
+        return (T)RESULT;
+    }
+
+    std::map<std::string, std::string> m_values;
+
+};
+
+/**
+ * Opens an output file.
+ * @throw std::runtime_error The file cannot be opened.
+ */
+static void openFile(std::ofstream& file, const std::string& name,
+                     std::ios::openmode mode = std::ios::trunc) {
+    file.open(name, mode);
+    if (file.fail()) {
+        throw std::runtime_error("Could not open \"" + name + "\".");
+    }
+}
+
+/**
+ * Runs an experiment like the exp_loop_func loop functions, without ARGoS.
+ * Usage: swarmlist_headless --protocol=consensus --topology=scalefree
+ *        --num_robots=5000 --res=res.csv --log=log.txt --fb_csv=status.csv
+ *        --tti_file=tti.csv [--threads=8] [--name=value...]
+ */
+int main(int argc, char** argv) {
+    try {
+        const Options OPTIONS(argc, argv);
+
+        swlexp::HeadlessSim::Config config;
+        config.protocol       = OPTIONS.get("protocol");
+        config.topology       = OPTIONS.get("topology");
+        config.numRobots      = OPTIONS.getNumber<argos::UInt32>("num_robots");
+        config.packetDropProb = OPTIONS.getNumber<argos::Real>  ("packet_drop_prob", config.packetDropProb);
+        config.packetSize     = OPTIONS.getNumber<argos::UInt16>("packet_size",      config.packetSize);
+        config.robotIdSize    = OPTIONS.getNumber<argos::UInt32>("robot_id_size",    config.robotIdSize);
+        config.lamportSize    = OPTIONS.getNumber<argos::UInt32>("lamport_size",     config.lamportSize);
+        config.scheduler      = OPTIONS.get                     ("scheduler",        config.scheduler.c_str());
+        config.hotQueueSize   = OPTIONS.getNumber<argos::UInt32>("hot_queue_size",   config.hotQueueSize);
+        config.digestPeriod   = OPTIONS.getNumber<argos::UInt32>("digest_period",    config.digestPeriod);
+        config.randomSeed     = OPTIONS.getNumber<argos::UInt32>("random_seed",      config.randomSeed);
+        config.numThreads     = OPTIONS.getNumber<argos::UInt32>("threads",          config.numThreads);
+        config.topologyFile   = OPTIONS.get                     ("topology_file",    "");
+        const argos::UInt32 STATUS_LOG_DELAY = OPTIONS.getNumber<argos::UInt32>("fb_status_log_delay", 0);
+        const argos::UInt32 MAX_STEPS        = OPTIONS.getNumber<argos::UInt32>("max_steps", 0);
+        const std::string RES_NAME         = OPTIONS.get("res");
+        const std::string LOG_NAME         = OPTIONS.get("log");
+        const std::string FB_CSV_NAME      = OPTIONS.get("fb_csv");
+        const std::string TTI_NAME         = OPTIONS.get("tti_file", "");
+        const std::string PROPAGATION_NAME = OPTIONS.get("propagation_file", "");
+        const std::string TRACE_NAME       = OPTIONS.get("trace_file", "");
+        if (config.protocol == "consensus" && TTI_NAME == "") {
+            throw std::invalid_argument("Missing argument --tti_file=...");
+        }
+
+        swlexp::HeadlessSim sim(config);
+
+        std::ofstream fbCsv;
+        std::ofstream res;
+        std::ofstream log;
+        openFile(fbCsv, FB_CSV_NAME);
+        openFile(res, RES_NAME);
+        openFile(log, LOG_NAME);
+        res << '\n' <<
+               config.protocol       << ',' <<
+               config.topology       << ',' <<
+               config.packetDropProb << ',' <<
+               config.numRobots;
+        log << "---EXPERIMENT START---\n"
+               "Protocol: " << config.protocol << "\n"
+               "Topology: " << config.topology << "\n"
+               "Drop probability: " << (config.packetDropProb * 100) << "%\n"
+               "Number of robots: " << config.numRobots << "\n"
+               "Swarm message format: " << config.robotIdSize << "-byte robot IDs, " <<
+                                           config.lamportSize << "-byte Lamport clocks\n"
+               "Scheduler: " << config.scheduler;
+        if (config.scheduler == "freshness") {
+            log << " (hot queue of " << config.hotQueueSize << " entries)";
+        }
+        log << "\n"
+               "Digest period: ";
+        if (config.digestPeriod > 0) {
+            log << config.digestPeriod << " timesteps\n";
+        }
+        else {
+            log << "none\n";
+        }
+        log << "Simulator: headless, " << sim.getNumThreads() << " thread(s)\n";
+        log.flush();
+
+        // Like ExpLoopFunc::Init().
+        if (PROPAGATION_NAME != "") {
+            swlexp::PropagationStats::getInst().init(config.numRobots);
+        }
+        if (TRACE_NAME != "") {
+            swlexp::TrafficTrace::getInst().init(config.protocol, config.numRobots);
+        }
+        sim.init();
+        if (config.topologyFile != "") {
+            log << "Topology file: " << config.topologyFile <<
+                   (sim.isTopologyLoaded() ? " (loaded)\n" : " (saved)\n");
+        }
+        log << "Links: " << sim.getGraph().getNumEdges() / 2 << "\n";
+        if (PROPAGATION_NAME != "") {
+            const swlexp::NeighbourGraph& GRAPH = sim.getGraph();
+            swlexp::PropagationStats::getInst().setHopSource([&GRAPH](swlexp::RobotId origin,
+                                                                      argos::UInt16* hops) {
+                GRAPH.computeHops(origin, hops);
+            });
+            log << "Propagation latencies: " << PROPAGATION_NAME << "\n";
+        }
+        log.flush();
+        swlexp::HeadlessSim::writeStatusLogHeader(fbCsv);
+        sim.writeStatusLogs(fbCsv, true);
+
+        // Like ExpLoopFunc::PostStep() and ExpLoopFunc::IsExperimentFinished().
+        while (!sim.isFinished()) {
+            if (MAX_STEPS > 0 && sim.getTime() >= MAX_STEPS) {
+                fbCsv.close();
+                res.close();
+                std::remove(FB_CSV_NAME.c_str());
+                std::remove(RES_NAME.c_str());
+                log << "---END---\n"
+                       "[ERROR] Maximum number of steps reached.\n";
+                throw std::runtime_error("Maximum number of steps reached.");
+            }
+            sim.step();
+            if (STATUS_LOG_DELAY > 0 && sim.getTime() % STATUS_LOG_DELAY == 0) {
+                sim.writeStatusLogs(fbCsv, true);
+            }
+        }
+
+        log << "---END---\n";
+        if (config.protocol == "consensus") {
+            std::ofstream tti;
+            openFile(tti, TTI_NAME);
+            sim.writeTtiData(tti);
+        }
+        sim.writeResults(res, log);
+        sim.writeStatusLogs(fbCsv, true);
+        if (PROPAGATION_NAME != "") {
+            std::ofstream propagation;
+            openFile(propagation, PROPAGATION_NAME, std::ios::trunc | std::ios::binary);
+            swlexp::PropagationStats::getInst().write(propagation);
+        }
+        if (TRACE_NAME != "") {
+            std::ofstream trace;
+            openFile(trace, TRACE_NAME, std::ios::trunc | std::ios::binary);
+            swlexp::TrafficTrace::getInst().write(trace);
+        }
+
+        std::cout << "Experiment finished normally in " << sim.getTime() <<
+                     " timesteps. See \"" << LOG_NAME << "\" for results.\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
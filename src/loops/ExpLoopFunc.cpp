@@ -2,6 +2,9 @@
 #include <list>
 
 #include "ExpLoopFunc.h"
+#include "PropagationStats.h"
+#include "TrafficTrace.h"
+#include "RobotPlacer.h"
 
 namespace swlexp {
     argos::UInt16 ExpLoopFunc::c_packetSize;
@@ -47,6 +50,9 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
     argos::GetNodeAttribute(t_tree, "res", m_expResName);
     argos::GetNodeAttribute(t_tree, "log", m_expLogName);
     argos::GetNodeAttribute(t_tree, "fb_csv", m_expFbCsvName);
+    argos::GetNodeAttributeOrDefault(t_tree, "propagation_file", m_propagationFileName, std::string(""));
+    argos::GetNodeAttributeOrDefault(t_tree, "trace_file", m_traceFileName, std::string(""));
+    argos::GetNodeAttributeOrDefault(t_tree, "topology_file", m_topologyFileName, std::string(""));
     argos::GetNodeAttribute(t_tree, "realtime_output_file", m_expRealtimeOutputName);
     argos::GetNodeAttribute(t_tree, "fb_status_log_delay", m_expStatusLogDelay);
     argos::GetNodeAttribute(t_tree, "steps_to_stall", m_expStepsToStall);
@@ -54,6 +60,16 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
     argos::GetNodeAttribute(t_tree, "protocol", m_protocol);
     argos::GetNodeAttribute(t_tree, "topology", m_topology);
     argos::GetNodeAttribute(t_tree, "num_robots", m_numRobots);
+    argos::UInt32 robotIdSize;
+    argos::UInt32 lamportSize;
+    argos::GetNodeAttributeOrDefault(t_tree, "robot_id_size", robotIdSize, (argos::UInt32)sizeof(RobotId));
+    argos::GetNodeAttributeOrDefault(t_tree, "lamport_size",  lamportSize, (argos::UInt32)sizeof(Lamport32));
+    std::string scheduler;
+    argos::UInt32 hotQueueSize;
+    argos::GetNodeAttributeOrDefault(t_tree, "scheduler", scheduler, std::string("roundrobin"));
+    argos::GetNodeAttributeOrDefault(t_tree, "hot_queue_size", hotQueueSize, Swarmlist::getHotQueueSize());
+    argos::UInt32 digestPeriod;
+    argos::GetNodeAttributeOrDefault(t_tree, "digest_period", digestPeriod, (argos::UInt32)0);
     std::string jobId;
     argos::GetNodeAttribute(t_tree, "job_id", jobId);
 
@@ -75,6 +91,32 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
         ++wtCStr;
     }
 
+    // Choose the wire format of swarm messages.
+    try {
+        Swarmlist::setWireFormat(robotIdSize, lamportSize);
+    }
+    catch (const std::domain_error& e) {
+        THROW_ARGOSEXCEPTION(e.what());
+    }
+    if (m_numRobots > 0 &&
+        m_numRobots - 1 > Swarmlist::getWireFormat().getMaxRobotId()) {
+        THROW_ARGOSEXCEPTION("Robot IDs of " << m_numRobots << " robots do not fit in " <<
+                             robotIdSize << "-byte robot IDs.");
+    }
+
+    // Choose how swarm messages are filled.
+    if (scheduler == "roundrobin") {
+        Swarmlist::setSchedulingPolicy(Swarmlist::SCHEDULING_ROUND_ROBIN);
+    }
+    else if (scheduler == "freshness") {
+        Swarmlist::setSchedulingPolicy(Swarmlist::SCHEDULING_FRESHNESS);
+    }
+    else {
+        THROW_ARGOSEXCEPTION("Unknown scheduler: \"" << scheduler << "\"");
+    }
+    Swarmlist::setHotQueueSize(hotQueueSize);
+    Swarmlist::setDigestPeriod(digestPeriod);
+
     // Open files.
     m_expFbCsv.open(m_expFbCsvName, std::ios::trunc);
     if (m_expFbCsv.fail()) {
@@ -112,7 +154,21 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
     m_expLog << "Protocol: " << m_protocol << "\n"
                 "Topology: " << m_topology << "\n"
                 "Drop probability: " << (m_msgDropProb * 100) << "%\n"
-                "Number of robots: " << m_numRobots << "\n";
+                "Number of robots: " << m_numRobots << "\n"
+                "Swarm message format: " << robotIdSize << "-byte robot IDs, " <<
+                                            lamportSize << "-byte Lamport clocks\n"
+                "Scheduler: " << scheduler;
+    if (scheduler == "freshness") {
+        m_expLog << " (hot queue of " << hotQueueSize << " entries)";
+    }
+    m_expLog << "\n"
+                "Digest period: ";
+    if (digestPeriod > 0) {
+        m_expLog << digestPeriod << " timesteps\n";
+    }
+    else {
+        m_expLog << "none\n";
+    }
 
     std::string toDisplayWalltime;
     if (m_expWalltime > 0) {
@@ -128,6 +184,7 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
                   "TOPOLOGY:         " << m_topology << "\n"
                   "DROP PROBABILITY: " << (m_msgDropProb * 100) << "%\n"
                   "NUMBER OF ROBOTS: " << m_numRobots << "\n"
+                  "SCHEDULER:        " << scheduler << "\n"
                   "--------------------------------------\n";
     m_expLog.flush();
 
@@ -147,7 +204,32 @@ void swlexp::ExpLoopFunc::Init(argos::TConfigurationNode& t_tree) {
     else {
         THROW_ARGOSEXCEPTION("Unknown protocol: \"" << m_protocol << "\"");
     }
+    // Record propagation latencies. This must start before the robots are
+    // placed, since they create their own entries when they are.
+    if (m_propagationFileName != "") {
+        PropagationStats::getInst().init(m_numRobots);
+    }
+    // Likewise, the robots start recording their packets when they are placed.
+    if (m_traceFileName != "") {
+        TrafficTrace::getInst().init(m_protocol, m_numRobots);
+    }
+    RobotPlacer::getInst().setTopologyFile(m_topologyFileName);
     m_state->init(m_topology, m_numRobots);
+    if (m_topologyFileName != "") {
+        m_expLog << "Topology file: " << m_topologyFileName <<
+                    (RobotPlacer::getInst().isTopologyLoaded() ? " (loaded)\n" : " (saved)\n");
+        m_expLog.flush();
+    }
+    if (m_propagationFileName != "") {
+        m_propagationGraph.build(RobotPlacer::getInst().getRobotPositions(m_numRobots),
+                                 RobotPlacer::getRabRange());
+        PropagationStats::getInst().setHopSource([this](RobotId origin, argos::UInt16* hops) {
+            m_propagationGraph.computeHops(origin, hops);
+        });
+        m_expLog << "Propagation latencies: " << m_propagationFileName << " (" <<
+                    m_propagationGraph.getNumEdges() / 2 << " links)\n";
+        m_expLog.flush();
+    }
 
     // Setup realtime output.
     m_timeAtLastRealtimeOutput = std::time(NULL);
@@ -173,9 +255,20 @@ void swlexp::ExpLoopFunc::Destroy() {
 /****************************************/
 /****************************************/
 
+void swlexp::ExpLoopFunc::PreStep() {
+    PropagationStats::getInst().setStep(GetSpace().GetSimulationClock());
+    TrafficTrace::getInst().setStep(GetSpace().GetSimulationClock());
+}
+
+/****************************************/
+/****************************************/
+
 void swlexp::ExpLoopFunc::PostStep() {
     static argos::UInt32 callsTillStatusLog = m_expStatusLogDelay - 1;
 
+    // The controllers recorded their first reaches in per-thread buffers.
+    PropagationStats::getInst().merge();
+
     // Write to realtime status log every hour.
     static const argos::UInt32 DELAY_FOR_REALTIME_LOG = 3600;
     std::time_t time = std::time(NULL);
@@ -237,23 +330,88 @@ void swlexp::ExpLoopFunc::_finishExperiment(swlexp::ExpLoopFunc::ExitCode exitCo
         argos::Real bwRx = ((argos::Real)NUM_MSGS_RX / GetSpace().GetSimulationClock() /
             NUM_FOOTBOTS) * c_packetSize;
 
+        // Traffic efficiency: what the sent bytes were made of, and what
+        // became of the received entries.
+        const argos::UInt64 SWARM_BYTES_TX =
+            swlexp::FootbotController::getTotalNumBytesTx(swlexp::Messenger::MSG_TYPE_SWARM);
+        const argos::UInt64 DIGEST_BYTES_TX =
+            swlexp::FootbotController::getTotalNumBytesTx(swlexp::Messenger::MSG_TYPE_DIGEST);
+        const argos::UInt64 MULTI_BYTES_TX =
+            swlexp::FootbotController::getTotalNumBytesTx(swlexp::Messenger::MSG_TYPE_MULTI);
+        const argos::UInt64 PADDING_BYTES_TX =
+            swlexp::FootbotController::getTotalNumPaddingBytesTx();
+        const argos::UInt64 TOTAL_BYTES_TX =
+            SWARM_BYTES_TX + DIGEST_BYTES_TX + MULTI_BYTES_TX + PADDING_BYTES_TX;
+        const argos::Real PACKET_UTILIZATION = (TOTAL_BYTES_TX > 0) ?
+            (argos::Real)(SWARM_BYTES_TX + DIGEST_BYTES_TX) / TOTAL_BYTES_TX : 0;
+        const argos::UInt64 ENTRIES_RX =
+            swlexp::FootbotController::getTotalNumEntriesRx();
+        const argos::UInt64 USEFUL_ENTRIES_RX =
+            swlexp::FootbotController::getTotalNumUsefulEntriesRx();
+        const argos::UInt64 DUPLICATE_ENTRIES_RX =
+            swlexp::FootbotController::getTotalNumDuplicateEntriesRx();
+        const argos::UInt64 REDUNDANT_ENTRIES_RX =
+            ENTRIES_RX - USEFUL_ENTRIES_RX - DUPLICATE_ENTRIES_RX;
+
         m_expRes << c_CSV_DELIM << GetSpace().GetSimulationClock() <<
                     c_CSV_DELIM << NUM_MSGS_TX <<
                     c_CSV_DELIM << NUM_MSGS_RX <<
                     c_CSV_DELIM << bwTx <<
-                    c_CSV_DELIM << bwRx;
+                    c_CSV_DELIM << bwRx <<
+                    c_CSV_DELIM << SWARM_BYTES_TX <<
+                    c_CSV_DELIM << DIGEST_BYTES_TX <<
+                    c_CSV_DELIM << MULTI_BYTES_TX <<
+                    c_CSV_DELIM << PADDING_BYTES_TX <<
+                    c_CSV_DELIM << PACKET_UTILIZATION <<
+                    c_CSV_DELIM << ENTRIES_RX <<
+                    c_CSV_DELIM << USEFUL_ENTRIES_RX <<
+                    c_CSV_DELIM << REDUNDANT_ENTRIES_RX <<
+                    c_CSV_DELIM << DUPLICATE_ENTRIES_RX;
         m_expRes.flush();
         m_expLog << "Consensus (ts): " << GetSpace().GetSimulationClock() << "\n"
                     "Msgs sent (total): " << NUM_MSGS_TX << "\n"
                     "Msgs received (total): " << NUM_MSGS_RX << "\n"
                     "Avg. sent bandwidth (B/(timestep*foot-bot)): " << bwTx << "\n"
                     "Avg. received bandwidth (B/(timestep*foot-bot)): " << bwRx << "\n"
+                    "Avg. swarmlist memory (B/foot-bot): " <<
+                    (swlexp::FootbotController::getTotalSwarmlistMemory() / NUM_FOOTBOTS) << "\n"
+                    "Messenger buffer allocations (total): " <<
+                    swlexp::FootbotController::getTotalNumMessengerAllocations() << "\n"
+                    "Swarm message bytes sent (total): " << SWARM_BYTES_TX << "\n"
+                    "Digest message bytes sent (total): " << DIGEST_BYTES_TX << "\n"
+                    "Multiplexing bytes sent (total): " << MULTI_BYTES_TX << "\n"
+                    "Padding bytes sent (total): " << PADDING_BYTES_TX << "\n"
+                    "Packets with several messages sent (total): " <<
+                    swlexp::FootbotController::getTotalNumMultiplexedTx() << "\n"
+                    "Packet utilization: " << PACKET_UTILIZATION << "\n"
+                    "Swarmlist entries received (total): " << ENTRIES_RX << "\n"
+                    "Useful swarmlist entries received (total): " << USEFUL_ENTRIES_RX << "\n"
+                    "Redundant swarmlist entries received (total): " << REDUNDANT_ENTRIES_RX << "\n"
+                    "Duplicate swarmlist entries received (total): " << DUPLICATE_ENTRIES_RX << "\n"
                     "\n";
         m_expLog.flush();
 
         swlexp::FootbotController::writeStatusLogs(m_expFbCsv, true);
         m_expFbCsv.flush();
 
+        if (m_propagationFileName != "") {
+            std::ofstream propagation(m_propagationFileName, std::ios::trunc | std::ios::binary);
+            if (propagation.fail()) {
+                THROW_ARGOSEXCEPTION("Could not open propagation file \"" <<
+                                     m_propagationFileName << "\".");
+            }
+            PropagationStats::getInst().write(propagation);
+        }
+
+        if (m_traceFileName != "") {
+            std::ofstream trace(m_traceFileName, std::ios::trunc | std::ios::binary);
+            if (trace.fail()) {
+                THROW_ARGOSEXCEPTION("Could not open trace file \"" <<
+                                     m_traceFileName << "\".");
+            }
+            TrafficTrace::getInst().write(trace);
+        }
+
         argos::LOG << "Experiment finished normally in " << GetSpace().GetSimulationClock() <<
                     " timesteps. See \"" << m_expLogName << "\" for results.\n";
     }
@@ -9,6 +9,7 @@
 
 #include "FootbotController.h"
 #include "ExpState.h"
+#include "NeighbourGraph.h"
 
 #ifndef EXP_LOOP_FUNC_H
 #define EXP_LOOP_FUNC_H
@@ -45,6 +46,7 @@ namespace swlexp {
         virtual void Init(argos::TConfigurationNode& t_tree);
         virtual void Destroy();
 
+        virtual void PreStep();
         virtual void PostStep();
         virtual bool IsExperimentFinished();
 
@@ -123,6 +125,32 @@ namespace swlexp {
          */
         std::ofstream m_expFbCsv;
 
+        /**
+         * Path to the binary file that the propagation latencies are written
+         * to at the end of the experiment ; empty if they are not recorded.
+         */
+        std::string m_propagationFileName;
+
+        /**
+         * Robots within communication range of each other, from which the
+         * hop distances of the propagation latencies are computed.
+         */
+        NeighbourGraph m_propagationGraph;
+
+        /**
+         * Path to the binary file that the packets received by the robots
+         * are written to at the end of the experiment, so that they can be
+         * replayed ; empty if they are not recorded.
+         */
+        std::string m_traceFileName;
+
+        /**
+         * Path to the binary file that the placement of the robots is
+         * loaded from if it exists, or saved to otherwise ; empty if the
+         * robots are always placed anew.
+         */
+        std::string m_topologyFileName;
+
         /**
          * Path to the file that we perform status logs into. Unlike the
          * foot-bots' status logs, whose contents we do not know on the batch
@@ -0,0 +1,101 @@
+#include <algorithm> // std::fill
+#include <stdexcept> // std::invalid_argument
+#include <utility>   // std::move
+
+#include "NeighbourGraph.h"
+
+namespace swlexp {
+    const argos::UInt16 NeighbourGraph::UNREACHABLE;
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::NeighbourGraph::NeighbourGraph()
+    : m_offsets(1, 0)
+{ }
+
+/****************************************/
+/****************************************/
+
+void swlexp::NeighbourGraph::build(const std::vector<argos::CVector2>& positions,
+                                   argos::Real range) {
+    const argos::UInt32 NUM_NODES = positions.size();
+    const argos::Real RANGE_SQUARED = range * range;
+
+    // Count the neighbours of each node, then fill the adjacency lists.
+    std::vector<argos::UInt32> degrees(NUM_NODES, 0);
+    for (argos::UInt32 i = 0; i < NUM_NODES; ++i) {
+        for (argos::UInt32 j = i + 1; j < NUM_NODES; ++j) {
+            if ((positions[i] - positions[j]).SquareLength() <= RANGE_SQUARED) {
+                ++degrees[i];
+                ++degrees[j];
+            }
+        }
+    }
+    m_offsets.assign(NUM_NODES + 1, 0);
+    for (argos::UInt32 i = 0; i < NUM_NODES; ++i) {
+        m_offsets[i+1] = m_offsets[i] + degrees[i];
+    }
+    m_neighbours.assign(m_offsets[NUM_NODES], 0);
+    std::vector<argos::UInt32> fill(m_offsets.begin(), m_offsets.end() - 1);
+    for (argos::UInt32 i = 0; i < NUM_NODES; ++i) {
+        for (argos::UInt32 j = i + 1; j < NUM_NODES; ++j) {
+            if ((positions[i] - positions[j]).SquareLength() <= RANGE_SQUARED) {
+                m_neighbours[fill[i]++] = j;
+                m_neighbours[fill[j]++] = i;
+            }
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::NeighbourGraph::assign(std::vector<argos::UInt32> offsets,
+                                    std::vector<argos::UInt32> neighbours) {
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != neighbours.size()) {
+        throw std::invalid_argument("The CSR offsets do not match the neighbours.");
+    }
+    const argos::UInt32 NUM_NODES = offsets.size() - 1;
+    for (argos::UInt32 i = 0; i < NUM_NODES; ++i) {
+        if (offsets[i] > offsets[i+1]) {
+            throw std::invalid_argument("The CSR offsets are not sorted.");
+        }
+    }
+    for (argos::UInt32 neighbour : neighbours) {
+        if (neighbour >= NUM_NODES) {
+            throw std::invalid_argument("A CSR neighbour is not a node.");
+        }
+    }
+    m_offsets    = std::move(offsets);
+    m_neighbours = std::move(neighbours);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::NeighbourGraph::computeHops(argos::UInt32 origin, argos::UInt16* hops) const {
+    const argos::UInt32 NUM_NODES = getNumNodes();
+    std::fill(hops, hops + NUM_NODES, UNREACHABLE);
+    if (origin >= NUM_NODES) {
+        return;
+    }
+
+    std::vector<argos::UInt32> queue;
+    queue.reserve(NUM_NODES);
+    queue.push_back(origin);
+    hops[origin] = 0;
+    for (argos::UInt32 head = 0; head < queue.size(); ++head) {
+        const argos::UInt32 NODE = queue[head];
+        const argos::UInt16 NEXT_HOPS =
+            (hops[NODE] < UNREACHABLE - 1) ? hops[NODE] + 1 : UNREACHABLE - 1;
+        for (argos::UInt32 e = m_offsets[NODE]; e < m_offsets[NODE+1]; ++e) {
+            const argos::UInt32 NEIGHBOUR = m_neighbours[e];
+            if (hops[NEIGHBOUR] == UNREACHABLE) {
+                hops[NEIGHBOUR] = NEXT_HOPS;
+                queue.push_back(NEIGHBOUR);
+            }
+        }
+    }
+}
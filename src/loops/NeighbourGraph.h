@@ -0,0 +1,96 @@
+#ifndef NEIGHBOUR_GRAPH_H
+#define NEIGHBOUR_GRAPH_H
+
+#include <argos3/core/utility/math/vector2.h>
+#include <vector>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * Graph of the robots that are within communication range of each
+     * other. Node 'i' is the robot whose ID is 'i'. The adjacency lists
+     * are stored contiguously (CSR): the neighbours of node 'i' are
+     * the elements [offsets[i],offsets[i+1]) of the neighbours array.
+     */
+    class NeighbourGraph {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        NeighbourGraph();
+
+        /**
+         * Builds the graph from the positions of the robots.
+         * @param[in] positions The position of each robot, indexed by ID.
+         * @param[in] range Distance below which two robots are neighbours.
+         */
+        void build(const std::vector<argos::CVector2>& positions, argos::Real range);
+
+        /**
+         * Sets the graph from its CSR arrays, e.g. read from a file.
+         * @throw std::invalid_argument The arrays are not a valid graph.
+         * @param[in] offsets The CSR offsets.
+         * @param[in] neighbours The CSR neighbours.
+         */
+        void assign(std::vector<argos::UInt32> offsets, std::vector<argos::UInt32> neighbours);
+
+        /**
+         * Determines the number of nodes.
+         */
+        inline
+        argos::UInt32 getNumNodes() const { return m_offsets.size() - 1; }
+
+        /**
+         * Determines the number of directed edges.
+         */
+        inline
+        argos::UInt32 getNumEdges() const { return m_neighbours.size(); }
+
+        /**
+         * Gets the CSR offsets ; there is one more offset than nodes.
+         */
+        inline
+        const std::vector<argos::UInt32>& getOffsets() const { return m_offsets; }
+
+        /**
+         * Gets the CSR neighbours.
+         */
+        inline
+        const std::vector<argos::UInt32>& getNeighbours() const { return m_neighbours; }
+
+        /**
+         * Computes the number of hops from a node to every node, with a
+         * breadth-first search.
+         * @param[in] origin The node to start from.
+         * @param[out] hops Node => Number of hops from the origin, or
+         * UNREACHABLE. Distances are capped to UNREACHABLE-1.
+         */
+        void computeHops(argos::UInt32 origin, argos::UInt16* hops) const;
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    public:
+
+        static const argos::UInt16 UNREACHABLE = (argos::UInt16)-1; ///< Hops to a node that cannot be reached.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        std::vector<argos::UInt32> m_offsets;    ///< Node => Position of its first neighbour in m_neighbours.
+        std::vector<argos::UInt32> m_neighbours; ///< Neighbours of every node, node after node.
+
+    };
+
+}
+
+#endif // !NEIGHBOUR_GRAPH_H
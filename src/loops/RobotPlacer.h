@@ -3,11 +3,15 @@
 
 #include <argos3/core/simulator/loop_functions.h>
 #include <argos3/core/simulator/entity/entity.h>
+#include <argos3/core/utility/math/vector2.h>
 #include <argos3/plugins/simulator/entities/box_entity.h>
 #include <argos3/plugins/simulator/entities/cylinder_entity.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
 #include <string>
+#include <vector>
 
 #include "include.h"
+#include "TopologyFile.h"
 
 namespace swlexp {
 
@@ -21,9 +25,29 @@ namespace swlexp {
 
         /**
          * Places the robots depending on the topology.
+         * If a topology file is set, the robots are placed like in the
+         * file if it holds the topology of the experiment ; otherwise,
+         * they are placed as usual and the file is written.
+         * Throws an ARGoS exception if the topology file cannot be saved,
+         * or if the robots it holds do not fit in the arena.
          */
         void placeRobots(std::string topology, argos::UInt32 numRobots, argos::CLoopFunctions& loops);
 
+        /**
+         * Sets the file to load the robots' placement from, or to save
+         * it to.
+         * @param[in] name The name of the file ; empty for none.
+         */
+        inline
+        void setTopologyFile(const std::string& name) { m_topologyFileName = name; }
+
+        /**
+         * Determines whether the robots were placed like in the topology
+         * file, rather than written to it.
+         */
+        inline
+        bool isTopologyLoaded() const { return m_isTopologyLoaded; }
+
         /**
          * Determines which robot currently is the farthest from the
          * arena's origin.
@@ -32,34 +56,34 @@ namespace swlexp {
          */
         argos::CEntity& findFarthestFromOrigin();
 
-    private:
-
         /**
-         * Places a certain number of robots in a line.
-         * @param[in] numRobots The number of robots to place.
+         * Gets the positions of the foot-bots on the arena.
+         * @param[in] numRobots Number of robots ; IDs at or above this
+         * number are ignored.
+         * @return Robot ID => Position on the ground. Robots that are not
+         * on the arena are infinitely far away.
          */
-        void _placeLine(argos::UInt32 numRobots);
+        std::vector<argos::CVector2> getRobotPositions(argos::UInt32 numRobots);
 
-        /**
-         * Places a certain number of robots in one large cluster in
-         * such a way that robots have a high number of neighbors in their
-         * communication range.
-         * @param[in] numRobots The number of robots to place.
-         */
-        void _placeScaleFree(argos::UInt32 numRobots);
+    private:
 
         /**
-         * Places a certain number of robots randomly inside a square.
-         * @param[in] numRobots The number of robots to place.
+         * Places the robots like in a topology file.
+         * Throws an ARGoS exception if a robot does not fit.
          */
-        void _placeCluster(argos::UInt32 numRobots);
+        void _loadTopology(const TopologyFile& file);
 
         /**
-         * Places a certain number of robots uniformly in an area.
-         * @param[in] numRobots The number of robots to place.
-         * @param[in] area The area to place the robots in.
+         * Creates a foot-bot if needed, and tries to move it to a position.
+         * Used as Topology::TPlacer.
+         * @param[in] robot The ID of the robot.
+         * @param[in] position The position on the ground.
+         * @param[in] orientation The orientation around the vertical axis.
+         * @return Whether the robot could be moved there.
          */
-        void _placeUniformly(argos::UInt32 numRobots, argos::CRange<argos::Real> area);
+        bool _placeFootbot(argos::UInt32 robot,
+                           const argos::CVector2& position,
+                           const argos::CRadians& orientation);
 
         /**
          * Places the walls of the arena.
@@ -92,7 +116,12 @@ namespace swlexp {
 
     private:
 
-        argos::CLoopFunctions* m_loops; ///< Loop functions to use to place the robots.
+        argos::CLoopFunctions* m_loops;  ///< Loop functions to use to place the robots.
+        argos::CFootBotEntity* m_placing; ///< Robot being placed.
+        std::string m_topologyFileName;   ///< File to load the placement from or save it to ; empty for none.
+        bool m_isTopologyLoaded;          ///< Whether the robots were placed like in the topology file.
+        std::vector<argos::CVector2> m_positions;    ///< Robot ID => Position it was placed at.
+        std::vector<argos::CRadians> m_orientations; ///< Robot ID => Orientation it was placed with.
 
     // ==============================
     // =       STATIC MEMBERS       =
@@ -0,0 +1,118 @@
+#ifndef SCALE_FREE_DATA_H
+#define SCALE_FREE_DATA_H
+
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/math/vector2.h>
+#include <algorithm> // std::min
+#include <vector>
+
+namespace swlexp {
+
+/**
+ * Scale-free placement data: the robots placed so far, with their number
+ * of connections. Pivots are picked with a probability proportional to
+ * their connections, through a Fenwick tree over the entries.
+ */
+struct SFData {
+
+   struct SEntry {
+      argos::UInt32 Conns;
+      argos::CVector2 Pos;
+      SEntry(argos::UInt32 un_conns,
+             const argos::CVector2& c_pos) :
+         Conns(un_conns),
+         Pos(c_pos) {}
+   };
+
+   /**
+    * @param[in] pc_rng The RNG the pivots are picked with.
+    */
+   explicit SFData(argos::CRandom::CRNG* pc_rng) :
+      Tree(1, 0),
+      TotConns(0),
+      RNG(pc_rng) {}
+
+   void Insert(const argos::CVector2& c_pos) {
+      /* Two connections to be added: entity <-> pivot */
+      TotConns += 2;
+      Data.push_back(SEntry(1, c_pos));
+      /* The new tree node sums the entries (i-LowBit(i),i], that is the
+         new entry and the nodes below it */
+      argos::UInt32 i = Data.size();
+      argos::UInt32 unSum = 1;
+      for(argos::UInt32 j = 1; j < LowBit(i); j <<= 1) {
+         unSum += Tree[i - j];
+      }
+      Tree.push_back(unSum);
+   }
+
+   void AddConn(argos::UInt32 un_entry) {
+      ++Data[un_entry].Conns;
+      for(argos::UInt32 i = un_entry + 1; i < Tree.size(); i += LowBit(i)) {
+         ++Tree[i];
+      }
+   }
+
+   const argos::CVector2& GetPos(argos::UInt32 un_entry) const {
+      return Data[un_entry].Pos;
+   }
+
+   argos::UInt32 GetNumEntries() const {
+      return Data.size();
+   }
+
+   argos::UInt32 GetTotConns() const {
+      return TotConns;
+   }
+
+   argos::UInt32 Pick() {
+      if(Data.size() > 1) {
+         /* More than 1 element stored, look for the pivot */
+         return Find(RNG->Uniform(argos::CRange<argos::UInt32>(0, TotConns)));
+      }
+      else if(Data.size() == 1) {
+         /* One element stored, just return that one */
+         return 0;
+      }
+      else THROW_ARGOSEXCEPTION("SFData::Pick(): empty structure");
+   }
+
+   /**
+    * Finds the first entry whose cumulated connections exceed x.
+    * @param[in] x A number of connections, at most TotConns.
+    * @return The entry ; the last one if none exceeds x.
+    */
+   argos::UInt32 Find(argos::UInt32 x) const {
+      argos::UInt32 unStep = 1;
+      while(unStep <= Data.size() / 2) {
+         unStep <<= 1;
+      }
+      /* Skip the entries whose cumulated connections do not exceed x */
+      argos::UInt32 unSkipped = 0;
+      for(; unStep > 0; unStep >>= 1) {
+         if(unSkipped + unStep <= Data.size() && Tree[unSkipped + unStep] <= x) {
+            unSkipped += unStep;
+            x -= Tree[unSkipped];
+         }
+      }
+      /* TotConns counts one more connection than the entries, so x
+         may exceed them all: the last entry is picked then */
+      return std::min<argos::UInt32>(unSkipped, Data.size() - 1);
+   }
+
+private:
+
+   static argos::UInt32 LowBit(argos::UInt32 i) {
+      return i & (~i + 1);
+   }
+
+   std::vector<SEntry> Data;
+   std::vector<argos::UInt32> Tree; ///< Fenwick tree of the connections, from index 1.
+   argos::UInt32 TotConns;
+   argos::CRandom::CRNG* RNG;
+
+};
+
+}
+
+#endif // !SCALE_FREE_DATA_H
@@ -0,0 +1,172 @@
+#include <argos3/core/utility/math/rng.h>
+
+#include "ScaleFreeData.h"
+#include "Topology.h"
+
+static const argos::UInt32 MAX_PLACE_TRIALS = 20;
+static const argos::UInt32 MAX_ROBOT_TRIALS = 20000;
+static const argos::Real   FOOTBOT_RADIUS   = 0.085036758f;
+static const argos::Real   FB_AREA          = ARGOS_PI * argos::Square(0.085036758f);
+static const argos::Real   DENSITY          = 0.1;
+
+/****************************************/
+/****************************************/
+
+using argos::CARGoSException; // Required because of the THROW_ARGOSEXCEPTION macro.
+
+argos::Real swlexp::Topology::getRabRange(const std::string& topology) {
+    if (topology == "line" || topology == "scalefree") {
+        return 0.19;
+    }
+    else if (topology == "cluster") {
+        return Sqrt(FB_AREA / DENSITY) * 2.0;
+    }
+    else {
+        THROW_ARGOSEXCEPTION("Unknown topology: " << topology);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Topology::place(
+        const std::string& topology,
+        argos::UInt32 numRobots,
+        const TPlacer& placer) {
+    const argos::Real RAB_RANGE = getRabRange(topology);
+    if (topology == "line") {
+        _placeLine(numRobots, RAB_RANGE, placer);
+    }
+    else if (topology == "scalefree") {
+        _placeScaleFree(numRobots, RAB_RANGE, placer);
+    }
+    else {
+        _placeCluster(numRobots, placer);
+    }
+}
+
+/****************************************/
+/****************************************/
+
+argos::Real swlexp::Topology::getFootbotRadius() {
+    return FOOTBOT_RADIUS;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Topology::_placeLine(argos::UInt32 numRobots, argos::Real rabRange, const TPlacer& placer) {
+    const argos::Real X_SPACING = 0.00, Y_SPACING = -(rabRange - 0.01);
+
+    // Place the footbots
+    argos::Real baseX = X_SPACING * (numRobots / 2.0);
+    argos::Real baseY = - Y_SPACING * (numRobots / 2.0);
+    for (argos::UInt32 i = 0; i < numRobots; ++i) {
+        argos::CVector2 pos = argos::CVector2(baseX + i * X_SPACING, baseY + i * Y_SPACING);
+        if (!placer(i, pos, argos::CRadians::ZERO)) {
+            THROW_ARGOSEXCEPTION(__FUNCTION__ << ": Can't place fb" << i);
+        }
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Topology::_placeCluster(argos::UInt32 un_robots, const TPlacer& placer) {
+   /* Calculate side of the region in which the robots are scattered */
+   argos::Real fHalfSide = Sqrt((FB_AREA * un_robots) / DENSITY) / 2.0f;
+   argos::CRange<argos::Real> cAreaRange(-fHalfSide, fHalfSide);
+   /* Place robots */
+   placeUniformly(un_robots, cAreaRange, placer);
+}
+
+/****************************************/
+/****************************************/
+
+static argos::Real GenerateCoordinate(argos::CRandom::CRNG* pc_rng, argos::Real f_rab_range) {
+   const argos::Real HALF_SF_RANGE = (f_rab_range / Sqrt(2)) * 0.5f;
+   argos::Real v = pc_rng->Uniform(argos::CRange<argos::Real>(-HALF_SF_RANGE, HALF_SF_RANGE));
+   if(v > 0.0) v += HALF_SF_RANGE;
+   else v -= HALF_SF_RANGE;
+   return v;
+}
+
+void swlexp::Topology::_placeScaleFree(argos::UInt32 un_robots, argos::Real f_rab_range, const TPlacer& placer) {
+   /* Data structures for the insertion of new robots */
+   argos::UInt32 unRobotTrials, unPlaceTrials;
+   argos::CVector2 cFBPos;
+   argos::CRadians cFBRot;
+   SFData sData(argos::CRandom::CreateRNG("argos"));
+   argos::UInt32 unPivot;
+   bool bDone;
+   /* Create a RNG (it is automatically disposed of by ARGoS) */
+   argos::CRandom::CRNG* pcRNG = argos::CRandom::CreateRNG("argos");
+   /* Add first robot in the origin */
+   if(un_robots == 0) {
+      return;
+   }
+   if(!placer(0, argos::CVector2(), argos::CRadians::ZERO)) {
+      THROW_ARGOSEXCEPTION(__FUNCTION__ << ": Can't place fb0");
+   }
+   sData.Insert(argos::CVector2());
+   /* Add other robots */
+   for(argos::UInt32 i = 1; i < un_robots; ++i) {
+      /* Retry choosing a pivot until you get a position or have an error */
+      unRobotTrials = 0;
+      do {
+         /* Choose a pivot */
+         ++unRobotTrials;
+         unPivot = sData.Pick();
+         cFBRot = pcRNG->Uniform(argos::CRadians::UNSIGNED_RANGE);
+         /* Try placing a robot close to this pivot */
+         unPlaceTrials = 0;
+         do {
+            ++unPlaceTrials;
+            /* Pick a position within the range of the pivot */
+            cFBPos.Set(GenerateCoordinate(pcRNG, f_rab_range),
+                       GenerateCoordinate(pcRNG, f_rab_range));
+            cFBPos += sData.GetPos(unPivot);
+            /* Try placing the robot */
+            bDone = placer(i, cFBPos, cFBRot);
+         }
+         while(!bDone && unPlaceTrials <= MAX_PLACE_TRIALS);
+      } while(!bDone && unRobotTrials <= MAX_ROBOT_TRIALS);
+      /* Was the robot placed successfully? */
+      if(!bDone) {
+         THROW_ARGOSEXCEPTION(__FUNCTION__ << ": Can't place fb" << i);
+      }
+      /* Yes, insert it in the data structure */
+      sData.AddConn(unPivot);
+      sData.Insert(cFBPos);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::Topology::placeUniformly(argos::UInt32 un_robots,
+                                      argos::CRange<argos::Real> c_area_range,
+                                      const TPlacer& placer) {
+   argos::UInt32 unTrials;
+   argos::CVector2 cFBPos;
+   argos::CRadians cFBRot;
+   /* Create a RNG (it is automatically disposed of by ARGoS) */
+   argos::CRandom::CRNG* pcRNG = argos::CRandom::CreateRNG("argos");
+   /* For each robot */
+   for(argos::UInt32 i = 0; i < un_robots; ++i) {
+      /* Try to place it in the arena */
+      unTrials = 0;
+      bool bDone;
+      do {
+         /* Choose a random position */
+         ++unTrials;
+         cFBPos.Set(pcRNG->Uniform(c_area_range),
+                    pcRNG->Uniform(c_area_range));
+         cFBRot = pcRNG->Uniform(argos::CRadians::UNSIGNED_RANGE);
+         bDone = placer(i, cFBPos, cFBRot);
+      } while(!bDone && unTrials <= MAX_PLACE_TRIALS);
+      if(!bDone) {
+         THROW_ARGOSEXCEPTION(__FUNCTION__ << ": Can't place fb" << i);
+      }
+   }
+}
@@ -0,0 +1,109 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <argos3/core/utility/math/angles.h>
+#include <argos3/core/utility/math/range.h>
+#include <argos3/core/utility/math/vector2.h>
+#include <functional>
+#include <string>
+
+#include "include.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Where the robots of each topology go.
+     * @details The positions are drawn without the simulator ; whether a
+     * robot fits at a position is left to a placer function, so that the
+     * same topologies are used by RobotPlacer, with the ARGoS arena, and
+     * by the headless simulator, with the robots' bodies only.
+     */
+    class Topology {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Tries to put a robot at a position.
+         * The robots are placed in the order of their IDs ; a robot may
+         * be tried at several positions before it fits.
+         * @param[in] robot The ID of the robot.
+         * @param[in] position The position on the ground.
+         * @param[in] orientation The orientation around the vertical axis.
+         * @return Whether the robot fits there.
+         */
+        typedef std::function<bool(argos::UInt32 robot,
+                                   const argos::CVector2& position,
+                                   const argos::CRadians& orientation)> TPlacer;
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Determines the communication range of the robots in a topology.
+         * Throws an ARGoS exception if the topology is unknown.
+         */
+        static
+        argos::Real getRabRange(const std::string& topology);
+
+        /**
+         * Places the robots depending on the topology.
+         * Throws an ARGoS exception if the topology is unknown, or if a
+         * robot cannot be placed.
+         * @param[in] topology The topology.
+         * @param[in] numRobots The number of robots to place.
+         * @param[in] placer Puts the robots at the positions drawn.
+         */
+        static
+        void place(const std::string& topology, argos::UInt32 numRobots, const TPlacer& placer);
+
+        /**
+         * Places a certain number of robots uniformly in an area.
+         * @param[in] numRobots The number of robots to place.
+         * @param[in] area The area to place the robots in.
+         * @param[in] placer Puts the robots at the positions drawn.
+         */
+        static
+        void placeUniformly(argos::UInt32 numRobots,
+                            argos::CRange<argos::Real> area,
+                            const TPlacer& placer);
+
+        /**
+         * Gets the radius of a foot-bot's body.
+         */
+        static
+        argos::Real getFootbotRadius();
+
+    private:
+
+        /**
+         * Places a certain number of robots in a line.
+         */
+        static
+        void _placeLine(argos::UInt32 numRobots, argos::Real rabRange, const TPlacer& placer);
+
+        /**
+         * Places a certain number of robots in one large cluster in
+         * such a way that robots have a high number of neighbors in their
+         * communication range.
+         */
+        static
+        void _placeScaleFree(argos::UInt32 numRobots, argos::Real rabRange, const TPlacer& placer);
+
+        /**
+         * Places a certain number of robots randomly inside a square.
+         */
+        static
+        void _placeCluster(argos::UInt32 numRobots, const TPlacer& placer);
+
+    };
+
+}
+
+#endif // !TOPOLOGY_H
@@ -0,0 +1,221 @@
+#include <cstdio>    // std::rename, std::remove
+#include <cstring>   // std::memcmp
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept> // std::runtime_error, std::invalid_argument
+#include <unistd.h>  // getpid
+#include <utility>   // std::move
+
+#include "TopologyFile.h"
+
+static const argos::UInt32 VERSION = 1;
+
+/**
+ * Writes a value in a binary stream.
+ */
+template <class T>
+static void writeBinary(std::ostream& o, T value) {
+    o.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * Reads a value from a binary stream.
+ * @throw std::runtime_error The stream ended.
+ */
+template <class T>
+static T readBinary(std::istream& i) {
+    T value;
+    if (!i.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("Truncated topology file.");
+    }
+    return value;
+}
+
+/**
+ * Reads an array of values from a binary stream.
+ * @throw std::runtime_error The stream ended.
+ */
+template <class T>
+static void readBinary(std::istream& i, std::vector<T>& values, argos::UInt32 size) {
+    values.resize(size);
+    if (!i.read(reinterpret_cast<char*>(values.data()), (std::streamsize)size * sizeof(T))) {
+        throw std::runtime_error("Truncated topology file.");
+    }
+}
+
+/**
+ * Determines the number of bytes left in a binary stream.
+ * @return The number of bytes left ; the largest value if the stream
+ * cannot tell.
+ */
+static argos::UInt64 bytesLeft(std::istream& i) {
+    const std::streampos POS = i.tellg();
+    if (POS == std::streampos(-1) || !i.seekg(0, std::ios::end)) {
+        i.clear();
+        return std::numeric_limits<argos::UInt64>::max();
+    }
+    const std::streampos END = i.tellg();
+    i.seekg(POS);
+    return (END > POS) ? (argos::UInt64)(END - POS) : 0;
+}
+
+/**
+ * Checks that a binary stream holds enough bytes for what is read next.
+ * @throw std::runtime_error It does not.
+ */
+static void checkBytesLeft(std::istream& i, argos::UInt64 size) {
+    if (size > bytesLeft(i)) {
+        throw std::runtime_error("Truncated topology file.");
+    }
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::TopologyFile::TopologyFile()
+    : m_randomSeed(0)
+    , m_rabRange(0)
+{ }
+
+/****************************************/
+/****************************************/
+
+void swlexp::TopologyFile::set(const std::string& topology,
+                               argos::UInt32 randomSeed,
+                               argos::Real rabRange,
+                               const std::vector<argos::CVector2>& positions,
+                               const std::vector<argos::CRadians>& orientations) {
+    m_topology     = topology;
+    m_randomSeed   = randomSeed;
+    m_rabRange     = rabRange;
+    m_positions    = positions;
+    m_orientations = orientations;
+    m_orientations.resize(m_positions.size());
+    m_graph.build(m_positions, m_rabRange);
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TopologyFile::write(std::ostream& o) const {
+    o.write("SWTP", 4);
+    writeBinary<argos::UInt32>(o, VERSION);
+    writeBinary<argos::UInt32>(o, m_topology.size());
+    o.write(m_topology.data(), m_topology.size());
+    writeBinary<argos::UInt32>(o, m_randomSeed);
+    writeBinary<argos::Real>  (o, m_rabRange);
+    writeBinary<argos::UInt32>(o, m_positions.size());
+
+    for (argos::UInt32 robot = 0; robot < m_positions.size(); ++robot) {
+        writeBinary<argos::Real>(o, m_positions[robot].GetX());
+        writeBinary<argos::Real>(o, m_positions[robot].GetY());
+        writeBinary<argos::Real>(o, m_orientations[robot].GetValue());
+    }
+
+    const std::vector<argos::UInt32>& OFFSETS    = m_graph.getOffsets();
+    const std::vector<argos::UInt32>& NEIGHBOURS = m_graph.getNeighbours();
+    writeBinary<argos::UInt32>(o, NEIGHBOURS.size());
+    o.write(reinterpret_cast<const char*>(OFFSETS.data()),    OFFSETS.size()    * sizeof(argos::UInt32));
+    o.write(reinterpret_cast<const char*>(NEIGHBOURS.data()), NEIGHBOURS.size() * sizeof(argos::UInt32));
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TopologyFile::read(std::istream& i) {
+    char magic[4];
+    if (!i.read(magic, 4) || std::memcmp(magic, "SWTP", 4) != 0) {
+        throw std::runtime_error("Not a topology file.");
+    }
+    if (readBinary<argos::UInt32>(i) != VERSION) {
+        throw std::runtime_error("Unsupported topology file version.");
+    }
+    const argos::UInt32 TOPOLOGY_SIZE = readBinary<argos::UInt32>(i);
+    checkBytesLeft(i, TOPOLOGY_SIZE);
+    m_topology.resize(TOPOLOGY_SIZE);
+    if (!i.read(&m_topology[0], m_topology.size())) {
+        throw std::runtime_error("Truncated topology file.");
+    }
+    m_randomSeed = readBinary<argos::UInt32>(i);
+    m_rabRange   = readBinary<argos::Real>  (i);
+
+    const argos::UInt32 NUM_ROBOTS = readBinary<argos::UInt32>(i);
+    checkBytesLeft(i, (argos::UInt64)NUM_ROBOTS * 3 * sizeof(argos::Real));
+    m_positions.resize(NUM_ROBOTS);
+    m_orientations.resize(NUM_ROBOTS);
+    for (argos::UInt32 robot = 0; robot < NUM_ROBOTS; ++robot) {
+        const argos::Real X = readBinary<argos::Real>(i);
+        const argos::Real Y = readBinary<argos::Real>(i);
+        m_positions[robot].Set(X, Y);
+        m_orientations[robot] = argos::CRadians(readBinary<argos::Real>(i));
+    }
+
+    const argos::UInt32 NUM_EDGES = readBinary<argos::UInt32>(i);
+    checkBytesLeft(i, ((argos::UInt64)NUM_ROBOTS + 1 + NUM_EDGES) * sizeof(argos::UInt32));
+    std::vector<argos::UInt32> offsets;
+    std::vector<argos::UInt32> neighbours;
+    readBinary(i, offsets, NUM_ROBOTS + 1);
+    readBinary(i, neighbours, NUM_EDGES);
+    try {
+        m_graph.assign(std::move(offsets), std::move(neighbours));
+    }
+    catch (const std::invalid_argument& e) {
+        throw std::runtime_error(std::string("Corrupt topology file: ") + e.what());
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TopologyFile::save(const std::string& fileName) const {
+    // The process ID keeps runs that save the same file at once apart.
+    const std::string TMP_NAME = fileName + ".tmp" + std::to_string(getpid());
+    std::ofstream out(TMP_NAME, std::ios::trunc | std::ios::binary);
+    if (out.fail()) {
+        throw std::runtime_error("Could not open \"" + TMP_NAME + "\".");
+    }
+    write(out);
+    out.close();
+    if (out.fail() || std::rename(TMP_NAME.c_str(), fileName.c_str()) != 0) {
+        std::remove(TMP_NAME.c_str());
+        throw std::runtime_error("Could not write \"" + fileName + "\".");
+    }
+}
+
+/****************************************/
+/****************************************/
+
+bool swlexp::TopologyFile::load(const std::string& fileName,
+                                const std::string& topology,
+                                argos::UInt32 numRobots,
+                                argos::UInt32 randomSeed) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    try {
+        read(in);
+        check(topology, numRobots, randomSeed);
+    }
+    catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::TopologyFile::check(const std::string& topology,
+                                 argos::UInt32 numRobots,
+                                 argos::UInt32 randomSeed) const {
+    if (topology != m_topology || numRobots != getNumRobots() || randomSeed != m_randomSeed) {
+        std::ostringstream error;
+        error << "The topology file has a " << m_topology << " topology of " <<
+                 getNumRobots() << " robots placed with seed " << m_randomSeed <<
+                 ", not a " << topology << " topology of " << numRobots <<
+                 " robots placed with seed " << randomSeed << ".";
+        throw std::runtime_error(error.str());
+    }
+}
@@ -0,0 +1,159 @@
+#ifndef TOPOLOGY_FILE_H
+#define TOPOLOGY_FILE_H
+
+#include <argos3/core/utility/math/angles.h>
+#include <argos3/core/utility/math/vector2.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "include.h"
+#include "NeighbourGraph.h"
+
+namespace swlexp {
+
+    /**
+     * Robots placed for a topology, with their neighbour graph, as saved
+     * in a binary file. The robots never move, so a run that loads the
+     * file uses the same graph as the run that wrote it, without placing
+     * the robots again. Files written by RobotPlacer and by the headless
+     * simulator can be loaded by either.
+     */
+    class TopologyFile {
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        TopologyFile();
+
+        /**
+         * Records the robots placed for a topology, and builds their
+         * neighbour graph.
+         * @param[in] topology The topology.
+         * @param[in] randomSeed The random seed the robots were placed with.
+         * @param[in] rabRange The communication range of the robots.
+         * @param[in] positions Robot ID => Position on the ground.
+         * @param[in] orientations Robot ID => Orientation around the
+         * vertical axis.
+         */
+        void set(const std::string& topology,
+                 argos::UInt32 randomSeed,
+                 argos::Real rabRange,
+                 const std::vector<argos::CVector2>& positions,
+                 const std::vector<argos::CRadians>& orientations);
+
+        /**
+         * Writes the topology in a binary stream.
+         * @param[out] o The binary stream to write to.
+         */
+        void write(std::ostream& o) const;
+
+        /**
+         * Reads a topology written by write().
+         * The lengths read are checked against the rest of the stream
+         * before anything is allocated for them.
+         * @throw std::runtime_error The stream does not hold a topology.
+         * @param[in] i The binary stream to read from.
+         */
+        void read(std::istream& i);
+
+        /**
+         * Writes the topology in a file. The file is written under a
+         * temporary name, then renamed, so that a run never loads a file
+         * that another run is still writing.
+         * @throw std::runtime_error The file cannot be written.
+         * @param[in] fileName The name of the file.
+         */
+        void save(const std::string& fileName) const;
+
+        /**
+         * Reads the topology of an experiment from a file written by save().
+         * A file that is missing, corrupt or saved for another experiment
+         * is a cache miss: the robots must be placed again, and the file
+         * overwritten.
+         * @param[in] fileName The name of the file.
+         * @param[in] topology The topology of the experiment.
+         * @param[in] numRobots The number of robots of the experiment.
+         * @param[in] randomSeed The random seed of the experiment.
+         * @return Whether the topology was loaded.
+         */
+        bool load(const std::string& fileName,
+                  const std::string& topology,
+                  argos::UInt32 numRobots,
+                  argos::UInt32 randomSeed);
+
+        /**
+         * Checks that the topology is the one an experiment asks for.
+         * @throw std::runtime_error It is not.
+         * @param[in] topology The topology of the experiment.
+         * @param[in] numRobots The number of robots of the experiment.
+         * @param[in] randomSeed The random seed of the experiment.
+         */
+        void check(const std::string& topology,
+                   argos::UInt32 numRobots,
+                   argos::UInt32 randomSeed) const;
+
+        /**
+         * Gets the name of the topology.
+         */
+        inline
+        const std::string& getTopology() const { return m_topology; }
+
+        /**
+         * Gets the random seed the robots were placed with.
+         */
+        inline
+        argos::UInt32 getRandomSeed() const { return m_randomSeed; }
+
+        /**
+         * Gets the communication range of the robots.
+         */
+        inline
+        argos::Real getRabRange() const { return m_rabRange; }
+
+        /**
+         * Gets the number of robots.
+         */
+        inline
+        argos::UInt32 getNumRobots() const { return m_positions.size(); }
+
+        /**
+         * Gets the positions of the robots, indexed by ID.
+         */
+        inline
+        const std::vector<argos::CVector2>& getPositions() const { return m_positions; }
+
+        /**
+         * Gets the orientations of the robots, indexed by ID.
+         */
+        inline
+        const std::vector<argos::CRadians>& getOrientations() const { return m_orientations; }
+
+        /**
+         * Gets the neighbour graph of the robots.
+         */
+        inline
+        const NeighbourGraph& getGraph() const { return m_graph; }
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        std::string m_topology;                    ///< Name of the topology.
+        argos::UInt32 m_randomSeed;                ///< Random seed the robots were placed with.
+        argos::Real m_rabRange;                    ///< Communication range of the robots.
+        std::vector<argos::CVector2> m_positions;  ///< Robot ID => Position on the ground.
+        std::vector<argos::CRadians> m_orientations; ///< Robot ID => Orientation around the vertical axis.
+        NeighbourGraph m_graph;                    ///< Robots within communication range of each other.
+
+    };
+
+}
+
+#endif // !TOPOLOGY_FILE_H
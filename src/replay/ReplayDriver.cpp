@@ -0,0 +1,131 @@
+#include <algorithm> // std::min, std::max, std::sort, std::binary_search
+#include <utility>   // std::move
+
+#include "ReplayDriver.h"
+
+namespace swlexp {
+    argos::UInt16 ReplayDriver::c_packetSize;
+}
+
+/****************************************/
+/****************************************/
+
+argos::UInt16 swlexp::getPacketSize() {
+    return swlexp::ReplayDriver::getPacketSize();
+}
+
+/****************************************/
+/****************************************/
+
+argos::Real swlexp::getPacketDropProb() {
+    // The dropped packets are not in the trace.
+    return 0;
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::ReplayDriver::ReplayDriver(const TrafficTrace& trace)
+    : m_trace(trace)
+{
+    const TrafficTrace::Settings& SETTINGS = trace.getSettings();
+    c_packetSize = SETTINGS.packetSize;
+    Swarmlist::setWireFormat(SETTINGS.robotIdSize, SETTINGS.lamportSize);
+    Swarmlist::setSchedulingPolicy((Swarmlist::SchedulingPolicy)SETTINGS.schedulingPolicy);
+    Swarmlist::setEntriesShouldBecomeInactive(SETTINGS.entriesShouldBecomeInactive != 0);
+    Swarmlist::Entry::setTicksToInactive(SETTINGS.ticksToInactive);
+    Swarmlist::setHotQueueSize(SETTINGS.hotQueueSize);
+    Swarmlist::setDigestPeriod(SETTINGS.digestPeriod);
+
+    // The swarmlists seed their random number generators from the
+    // simulator's category, so it gets the seed of the recording.
+    if (argos::CRandom::ExistsCategory("argos")) {
+        argos::CRandom::RemoveCategory("argos");
+    }
+    argos::CRandom::CreateCategory("argos", SETTINGS.randomSeed);
+}
+
+/****************************************/
+/****************************************/
+
+swlexp::ReplayDriver::Result swlexp::ReplayDriver::run() {
+    const std::vector<std::unique_ptr<TrafficTrace::RobotTrace>>& TRACES = m_trace.getRobots();
+    const TrafficTrace::Settings& SETTINGS = m_trace.getSettings();
+
+    Result result = { 0, 0, 0, 0 };
+    std::vector<std::unique_ptr<Robot>> robots;
+    argos::UInt32 firstStep = (argos::UInt32)-1;
+    argos::UInt32 endStep = 0;
+    for (const std::unique_ptr<TrafficTrace::RobotTrace>& trace : TRACES) {
+        std::unique_ptr<Robot> robot(new Robot);
+        robot->messenger.init(&robot->transmitter, &robot->receiver);
+        robot->trace = trace.get();
+        firstStep = std::min(firstStep, trace->getFirstStep());
+        endStep   = std::max(endStep, trace->getFirstStep() + trace->getNumSteps());
+        robots.push_back(std::move(robot));
+    }
+
+    for (argos::UInt32 step = firstStep; step < endStep; ++step) {
+        // Like FootbotController::Init(). The robots that are removed
+        // without a step are set up too, since they may take part in a
+        // consensus.
+        for (std::unique_ptr<Robot>& robot : robots) {
+            if (step == robot->trace->getFirstStep()) {
+                robot->swarmlist.init(robot->trace->getRobotId(), SETTINGS.denseIdBound);
+                robot->swarmlist.setSwarmMask(0x01);
+            }
+        }
+        if (SETTINGS.consensusStep != TrafficTrace::NO_CONSENSUS &&
+            step == SETTINGS.consensusStep + 1) {
+            _forceConsensus(robots, step);
+        }
+
+        argos::UInt64 numActive = 0;
+        for (std::unique_ptr<Robot>& robot : robots) {
+            const TrafficTrace::RobotTrace& TRACE = *robot->trace;
+            if (step < TRACE.getFirstStep() ||
+                step >= TRACE.getFirstStep() + TRACE.getNumSteps()) {
+                continue;
+            }
+
+            // Like FootbotController::ControlStep().
+            robot->pos = TRACE.readStep(robot->pos, robot->receiver.getReadings());
+            result.numPackets += robot->receiver.getReadings().size();
+            robot->messenger.controlStep();
+            robot->swarmlist.controlStep();
+            robot->messenger.flushTx();
+            numActive += robot->swarmlist.getNumActive();
+        }
+        result.checksum = result.checksum * 1000003 + numActive;
+        ++result.numSteps;
+    }
+
+    for (const std::unique_ptr<Robot>& robot : robots) {
+        if (robot->trace->getNumSteps() > 0) {
+            result.numActive += robot->swarmlist.getNumActive();
+        }
+    }
+    return result;
+}
+
+/****************************************/
+/****************************************/
+
+void swlexp::ReplayDriver::_forceConsensus(std::vector<std::unique_ptr<Robot>>& robots,
+                                           argos::UInt32 step) {
+    // Like FootbotController::forceConsensus(), on the robots that were
+    // present and whose trace had not ended.
+    const std::vector<RobotId>& PRESENT = m_trace.getSettings().consensusRobots;
+    Swarmlist::prepareConsensus(PRESENT, m_trace.getSettings().denseIdBound);
+    std::vector<RobotId> sortedPresent = PRESENT;
+    std::sort(sortedPresent.begin(), sortedPresent.end());
+    for (std::unique_ptr<Robot>& robot : robots) {
+        const TrafficTrace::RobotTrace& TRACE = *robot->trace;
+        if (TRACE.getFirstStep() <= step &&
+            step <= TRACE.getFirstStep() + TRACE.getNumSteps() &&
+            std::binary_search(sortedPresent.begin(), sortedPresent.end(), TRACE.getRobotId())) {
+            robot->swarmlist.forceConsensus();
+            robot->messenger.resetCounters();
+        }
+    }
+}
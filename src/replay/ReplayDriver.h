@@ -0,0 +1,150 @@
+/**
+ * @file ReplayDriver.h
+ * @brief Definition of the ReplayDriver class.
+ */
+
+#ifndef REPLAY_DRIVER_H
+#define REPLAY_DRIVER_H
+
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_actuator.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
+#include <memory>
+#include <vector>
+
+#include "Messenger.h"
+#include "Swarmlist.h"
+#include "TrafficTrace.h"
+
+namespace swlexp {
+
+    /**
+     * @brief Feeds a recorded traffic trace to fresh swarmlists, without
+     * the simulator.
+     * @details Each robot of the trace gets a messenger and a swarmlist,
+     * which are stepped like in FootbotController::ControlStep(), on the
+     * packets that the robot received. What the swarmlists send is
+     * discarded. The swarmlists are forced to consensus at the step of the
+     * recording, and their random numbers come from the seed of the
+     * recording ; since they are deterministic, a replay leaves them in
+     * the state they were in at the end of the recording.
+     */
+    class ReplayDriver {
+
+    // ==============================
+    // =       NESTED SYMBOLS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Totals of a replay.
+         */
+        struct Result {
+            argos::UInt32 numSteps;   ///< Number of steps replayed.
+            argos::UInt64 numPackets; ///< Number of packets fed to the messengers.
+            argos::UInt64 numActive;  ///< Number of active entries at the end, over all robots.
+            argos::UInt64 checksum;   ///< Hash of the number of active entries at every step.
+        };
+
+    private:
+
+        /**
+         * Range and bearing actuator whose packets are discarded.
+         * Its buffer has the size of the packets of the trace, as
+         * SetData() requires.
+         */
+        class ReplayTransmitter : public argos::CCI_RangeAndBearingActuator {
+        public:
+            ReplayTransmitter() { m_cData.Resize(getPacketSize()); }
+        };
+
+        /**
+         * Range and bearing sensor whose readings are set by the driver.
+         */
+        class ReplayReceiver : public argos::CCI_RangeAndBearingSensor {
+        public:
+            inline
+            TReadings& getReadings() { return m_tReadings; }
+        };
+
+        /**
+         * Everything a robot of the trace needs to be stepped.
+         */
+        struct Robot {
+            Robot() : swarmlist(&messenger), trace(nullptr), pos(0) {}
+            ReplayTransmitter transmitter;
+            ReplayReceiver receiver;
+            Messenger messenger;
+            Swarmlist swarmlist;
+            const TrafficTrace::RobotTrace* trace; ///< Packets of the robot.
+            size_t pos;                            ///< Position of the next step in the trace.
+        };
+
+    // ==============================
+    // =          METHODS           =
+    // ==============================
+
+    public:
+
+        /**
+         * Class constructor.
+         * Sets the swarmlists up with the settings of the recording, and
+         * creates the "argos" random category with its seed.
+         * @throw std::domain_error The settings are not supported.
+         * @param[in] trace The trace ; it must outlive the driver.
+         */
+        explicit
+        ReplayDriver(const TrafficTrace& trace);
+
+        /**
+         * Replays the whole trace once, with fresh swarmlists.
+         * @return The totals of the replay.
+         */
+        Result run();
+
+    private:
+
+        ReplayDriver(ReplayDriver&) = delete;
+        ReplayDriver& operator=(const ReplayDriver&) = delete;
+
+        /**
+         * Forces the swarmlists of the robots present at the consensus of
+         * the recording to consensus.
+         * @param[in] robots The robots of the trace.
+         * @param[in] step The step about to be replayed.
+         */
+        void _forceConsensus(std::vector<std::unique_ptr<Robot>>& robots, argos::UInt32 step);
+
+    // ==============================
+    // =       STATIC METHODS       =
+    // ==============================
+
+    public:
+
+        /**
+         * Gets the size of the packets of the trace.
+         */
+        inline static
+        argos::UInt16 getPacketSize() { return c_packetSize; }
+
+    // ==============================
+    // =       STATIC MEMBERS       =
+    // ==============================
+
+    private:
+
+        static argos::UInt16 c_packetSize; ///< Size of the packets of the trace.
+
+    // ==============================
+    // =         ATTRIBUTES         =
+    // ==============================
+
+    private:
+
+        const TrafficTrace& m_trace; ///< Trace being replayed.
+
+    };
+
+}
+
+#endif // !REPLAY_DRIVER_H
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "ReplayDriver.h"
+
+/**
+ * Replays a traffic trace recorded with the 'trace_file' attribute of
+ * the loop functions, and prints how long the swarmlists took.
+ * Usage: swarmlist_replay <trace file> [number of runs]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [number of runs]\n";
+        return 1;
+    }
+    const int NUM_RUNS = (argc > 2) ? std::atoi(argv[2]) : 1;
+
+    swlexp::TrafficTrace trace;
+    try {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (file.fail()) {
+            throw std::runtime_error(std::string("Could not open \"") + argv[1] + "\".");
+        }
+        trace.read(file);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    swlexp::ReplayDriver driver(trace);
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        const auto START = std::chrono::steady_clock::now();
+        const swlexp::ReplayDriver::Result RESULT = driver.run();
+        const double SECONDS = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - START).count();
+
+        std::cout << "Run " << run << ": " <<
+                     trace.getRobots().size() << " robots, " <<
+                     RESULT.numSteps << " steps, " <<
+                     RESULT.numPackets << " packets in " << SECONDS << " s (" <<
+                     RESULT.numPackets / SECONDS << " packets/s) ; " <<
+                     "active entries: " << RESULT.numActive << ", " <<
+                     "checksum: " << std::hex << RESULT.checksum << std::dec << "\n";
+    }
+    return 0;
+}